@@ -1,360 +1,4554 @@
 #include <cassert>
-#include <cmath> // std::floor
-#include <exception> // std::invalid_argument
+#include <stdexcept> // std::invalid_argument, std::domain_error,
+                     // std::runtime_error
+#include <algorithm> // std::min, std::max, std::fill, std::copy
+#include <atomic>
+#include <chrono>
+#include <cmath> // std::sqrt, std::log2, std::exp2
+#include <condition_variable>
+#include <cstring> // std::memcpy
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "BigInt.h"
 
+// the vectorized kernels are x86-64 only and use GCC/Clang target
+// attributes; defining BIGINT_NO_SIMD leaves just the portable loops
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(BIGINT_NO_SIMD)
+#define BIGINT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+// files are memory-mapped on POSIX systems and read into memory elsewhere
+#if defined(__unix__) || defined(__APPLE__)
+#define BIGINT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// all double-precision intermediates (products and carries of two
+// 64-bit digits) are computed in 128 bits. __extension__ keeps
+// -pedantic from rejecting the non-standard type.
+__extension__ typedef unsigned __int128 uint128_t;
+__extension__ typedef __int128 int128_t;
+
+// the largest power of ten that fits in a single digit, 10^19, and the
+// number of decimal digits it covers. Decimal conversion works in
+// chunks of this size.
+static const uint64_t DEC_CHUNK = 10000000000000000000ULL;
+static const size_t DEC_CHUNK_DIGITS = 19;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static const bool LITTLE_ENDIAN_HOST = true;
+#else
+static const bool LITTLE_ENDIAN_HOST = false;
+#endif
+
 // vvvvvvvvvv HELPER FUNCTIONS vvvvvvvvvv
 
 // remove leading zeros
-static void rem_lzeros(std::vector<int>& a) {
+static void rem_lzeros(DigitVector& a) {
     while (a.size() > 1 && a.back() == 0) {
         a.pop_back();
     }
 }
 
-// compute a mod b
-static int mod(const int a, const int b) {
-    return a - b * int(std::floor(float(a) / b));
+// vvvvv statistics vvvvv
+//
+// With BIGINT_STATS defined, STATS_OPERATION times and counts the public
+// operation it is placed in, until the end of the enclosing scope, and
+// STATS_ALGORITHM counts the algorithm a helper picks. Where the operand
+// size is only known later (as when reading a stream), STATS_DIGITS
+// sets it before the scope ends. Without BIGINT_STATS they expand to
+// nothing and their arguments are never evaluated.
+
+#ifdef BIGINT_STATS
+
+#define STATS_OPERATION(op, digits) \
+    OperationTimer stats_timer_(BigIntStats::op, digits)
+#define STATS_DIGITS(digits) stats_timer_.set_digits(digits)
+#define STATS_ALGORITHM(a) count_algorithm(BigIntStats::a)
+
+// The counters of one thread. Only that thread writes them, with a plain
+// load and store rather than a locked add; other threads only read them,
+// for snapshots.
+struct ThreadStats {
+    typedef std::atomic<uint64_t> Counter;
+
+    struct OperationCounters {
+        Counter calls{0};
+        Counter cycles{0};
+        Counter sizes[BigIntStats::SIZE_BUCKETS] = {};
+    };
+
+    OperationCounters operations[BigIntStats::OPERATION_COUNT];
+    Counter algorithms[BigIntStats::ALGORITHM_COUNT] = {};
+    Counter allocations{0};
+    Counter allocated_bytes{0};
+
+    static void bump(Counter& c, const uint64_t n = 1) {
+        c.store(c.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+    }
+
+    void add_to(BigIntStats& s) const {
+        for (size_t i = 0; i < BigIntStats::OPERATION_COUNT; ++i) {
+            s.operations[i].calls += operations[i].calls.load();
+            s.operations[i].cycles += operations[i].cycles.load();
+            for (size_t j = 0; j < BigIntStats::SIZE_BUCKETS; ++j) {
+                s.operations[i].sizes[j] += operations[i].sizes[j].load();
+            }
+        }
+        for (size_t i = 0; i < BigIntStats::ALGORITHM_COUNT; ++i) {
+            s.algorithms[i] += algorithms[i].load();
+        }
+        s.allocations += allocations.load();
+        s.allocated_bytes += allocated_bytes.load();
+    }
+};
+
+// every live thread's counters, the totals of threads that have exited,
+// and the totals as of the last reset
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<const ThreadStats*> live;
+    BigIntStats exited;
+    BigIntStats baseline;
+};
+
+// never destroyed, as threads may exit after static destruction starts
+static StatsRegistry& stats_registry() {
+    static StatsRegistry* registry = new StatsRegistry();
+    return *registry;
+}
+
+// a thread's counters, registered for as long as the thread runs
+class ThreadStatsHolder {
+    public:
+        ThreadStatsHolder() {
+            StatsRegistry& r = stats_registry();
+            const std::lock_guard<std::mutex> lock(r.mutex);
+            r.live.push_back(&stats);
+        }
+
+        ~ThreadStatsHolder() {
+            StatsRegistry& r = stats_registry();
+            const std::lock_guard<std::mutex> lock(r.mutex);
+            stats.add_to(r.exited);
+            r.live.erase(std::find(r.live.begin(), r.live.end(), &stats));
+        }
+
+        ThreadStats stats;
+};
+
+static ThreadStats& thread_stats() {
+    static thread_local ThreadStatsHolder holder;
+    return holder.stats;
+}
+
+static uint64_t stats_clock() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    return __builtin_ia32_rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+class OperationTimer {
+    public:
+        OperationTimer(const BigIntStats::Operation op,
+                       const size_t digits_in)
+            : counters(thread_stats().operations[op]),
+              digits(digits_in), start(stats_clock()) { }
+
+        ~OperationTimer() {
+            ThreadStats::bump(counters.cycles, stats_clock() - start);
+            ThreadStats::bump(counters.calls);
+            size_t bucket = 0;
+            for (size_t n = digits; n > 0; n >>= 1) {
+                ++bucket;
+            }
+            ThreadStats::bump(counters.sizes[std::min(bucket,
+                                             BigIntStats::SIZE_BUCKETS - 1)]);
+        }
+
+        OperationTimer(const OperationTimer&) = delete;
+        OperationTimer& operator=(const OperationTimer&) = delete;
+
+        void set_digits(const size_t n) { digits = n; }
+
+    private:
+        ThreadStats::OperationCounters& counters;
+        size_t digits;
+        const uint64_t start;
+};
+
+static void count_algorithm(const BigIntStats::Algorithm a) {
+    ThreadStats::bump(thread_stats().algorithms[a]);
+}
+
+// see DigitVector.h
+extern const char bigint_library_built_with_BIGINT_STATS = 0;
+
+void bigint_stats_allocation(const size_t bytes) {
+    ThreadStats& s = thread_stats();
+    ThreadStats::bump(s.allocations);
+    ThreadStats::bump(s.allocated_bytes, bytes);
+}
+
+#else
+
+extern const char bigint_library_built_without_BIGINT_STATS = 0;
+
+#define STATS_OPERATION(op, digits) ((void)0)
+#define STATS_DIGITS(digits) ((void)0)
+#define STATS_ALGORITHM(a) ((void)0)
+
+#endif // BIGINT_STATS
+
+// ^^^^^ statistics ^^^^^
+
+// vvvvv raw digit-array kernels vvvvv
+//
+// These operate on pointers to digit arrays of given lengths (least-
+// significant digit first), so that the recursive algorithms below can
+// work on slices of a number without copying them into new vectors.
+// Outputs may alias inputs exactly (r == a) but must not partially overlap.
+
+// r[0..n) = a[0..n) + b[0..n) + carry, returning the carry out
+static uint64_t add_nc(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                       const size_t n, uint64_t carry) {
+    for (size_t i = 0; i < n; ++i) {
+        uint128_t partial_sum = uint128_t(a[i]) + b[i] + carry;
+        r[i] = uint64_t(partial_sum);
+        carry = uint64_t(partial_sum >> 64);
+    }
+    return carry;
+}
+
+// r[0..n) = a[0..n) + c, returning the carry out
+static uint64_t add_1(uint64_t* r, const uint64_t* a, const size_t n,
+                      uint64_t c) {
+    for (size_t i = 0; i < n; ++i) {
+        if (c == 0 && r == a) {
+            break; // nothing left to propagate in place
+        }
+        uint128_t partial_sum = uint128_t(a[i]) + c;
+        r[i] = uint64_t(partial_sum);
+        c = uint64_t(partial_sum >> 64);
+    }
+    return c;
+}
+
+// r[0..n) = a[0..n) - c, returning the borrow out
+static uint64_t sub_1(uint64_t* r, const uint64_t* a, const size_t n,
+                      uint64_t c) {
+    for (size_t i = 0; i < n; ++i) {
+        if (c == 0 && r == a) {
+            break;
+        }
+        uint128_t partial_sub = uint128_t(a[i]) - c;
+        r[i] = uint64_t(partial_sub);
+        c = uint64_t(partial_sub >> 64) ? 1 : 0;
+    }
+    return c;
+}
+
+// r[0..n) = a[0..n) - b[0..n) - borrow, returning the borrow out
+static uint64_t sub_nc(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                       const size_t n, uint64_t borrow) {
+    for (size_t i = 0; i < n; ++i) {
+        // a negative partial difference wraps around modulo 2^128, so its
+        // high half is all ones exactly when we need to borrow
+        uint128_t partial_sub = uint128_t(a[i]) - b[i] - borrow;
+        r[i] = uint64_t(partial_sub);
+        borrow = uint64_t(partial_sub >> 64) ? 1 : 0;
+    }
+    return borrow;
+}
+
+static uint64_t add_n_scalar(uint64_t* r, const uint64_t* a,
+                             const uint64_t* b, const size_t n) {
+    return add_nc(r, a, b, n, 0);
+}
+
+static uint64_t sub_n_scalar(uint64_t* r, const uint64_t* a,
+                             const uint64_t* b, const size_t n) {
+    return sub_nc(r, a, b, n, 0);
+}
+
+// compare a[0..n) with b[0..n), returning -1, 0 or 1 as a is less than,
+// equal to or greater than b
+static int cmp_n_scalar(const uint64_t* a, const uint64_t* b,
+                        const size_t n) {
+    for (size_t i = n; i-- > 0; ) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// vvv vector kernels vvv
+//
+// Vectorized forms of add_n, sub_n and cmp_n, chosen at run time from
+// what the CPU supports: AVX-512F, then AVX2, then the portable loops
+// above. A block of digits is added lane by lane, and the carries between
+// lanes are then resolved all at once, as in a carry-lookahead adder: a
+// lane generates a carry if its sum wrapped around and propagates an
+// incoming one if its sum is all ones, so with these as bit masks g and p
+// the lanes that receive a carry are the bits of ((g << 1) + p + c) ^ p,
+// where c is the carry into the block, and the bit just past the top lane
+// is the carry out of it. Subtraction is the same with borrows, where a
+// lane propagates if its difference is zero.
+//
+// The multiply-accumulate row (mul_basecase) stays scalar: there is no
+// vector 64x64-bit multiply short of AVX-512 IFMA's 52-bit digits, and a
+// MULX/ADX row measured no faster than the compiler's code for the
+// 128-bit loop. SSE2 has no 64-bit compares, so it gets no kernel.
+
+#ifdef BIGINT_X86_KERNELS
+
+// lanes of all ones for the set bits of a 4-bit mask, zero for the rest
+__attribute__((target("avx2")))
+static __m256i lane_mask_avx2(const unsigned m) {
+    const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_cmpeq_epi64(
+        _mm256_and_si256(_mm256_set1_epi64x(m), bits), bits);
+}
+
+// bit i set for each lane i of x that is all ones
+__attribute__((target("avx2")))
+static unsigned lane_bits_avx2(const __m256i x) {
+    return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(x)));
+}
+
+// x < y for unsigned lanes; AVX2 only has signed compares, so compare
+// with the top bits flipped
+__attribute__((target("avx2")))
+static __m256i less_avx2(const __m256i x, const __m256i y) {
+    const __m256i top = _mm256_set1_epi64x(INT64_MIN);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(y, top),
+                              _mm256_xor_si256(x, top));
+}
+
+__attribute__((target("avx2")))
+static uint64_t add_n_avx2(uint64_t* r, const uint64_t* a,
+                           const uint64_t* b, const size_t n) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i s = _mm256_add_epi64(x, y);
+        unsigned g = lane_bits_avx2(less_avx2(s, x));
+        unsigned p = lane_bits_avx2(_mm256_cmpeq_epi64(s, ones));
+        unsigned c = (g << 1) + p + carry;
+        // subtracting all ones adds the carry
+        s = _mm256_sub_epi64(s, lane_mask_avx2((c ^ p) & 0xf));
+        _mm256_storeu_si256((__m256i*)(r + i), s);
+        carry = c >> 4;
+    }
+    return add_nc(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sub_n_avx2(uint64_t* r, const uint64_t* a,
+                           const uint64_t* b, const size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i s = _mm256_sub_epi64(x, y);
+        unsigned g = lane_bits_avx2(less_avx2(x, y));
+        unsigned p = lane_bits_avx2(_mm256_cmpeq_epi64(s, zero));
+        unsigned c = (g << 1) + p + borrow;
+        // adding all ones subtracts the borrow
+        s = _mm256_add_epi64(s, lane_mask_avx2((c ^ p) & 0xf));
+        _mm256_storeu_si256((__m256i*)(r + i), s);
+        borrow = c >> 4;
+    }
+    return sub_nc(r + i, a + i, b + i, n - i, borrow);
+}
+
+// skips down past equal blocks of four digits
+__attribute__((target("avx2")))
+static int cmp_n_avx2(const uint64_t* a, const uint64_t* b, const size_t n) {
+    size_t i = n;
+    while (i >= 4) {
+        i -= 4;
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        unsigned ne = ~lane_bits_avx2(_mm256_cmpeq_epi64(x, y)) & 0xf;
+        if (ne) {
+            size_t top = i + 31 - size_t(__builtin_clz(ne));
+            return a[top] < b[top] ? -1 : 1;
+        }
+    }
+    return cmp_n_scalar(a, b, i);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t add_n_avx512(uint64_t* r, const uint64_t* a,
+                             const uint64_t* b, const size_t n) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i s = _mm512_add_epi64(x, y);
+        unsigned g = _mm512_cmplt_epu64_mask(s, x);
+        unsigned p = _mm512_cmpeq_epi64_mask(s, ones);
+        unsigned c = (g << 1) + p + carry;
+        s = _mm512_mask_sub_epi64(s, __mmask8((c ^ p) & 0xff), s, ones);
+        _mm512_storeu_si512(r + i, s);
+        carry = c >> 8;
+    }
+    return add_nc(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t sub_n_avx512(uint64_t* r, const uint64_t* a,
+                             const uint64_t* b, const size_t n) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    const __m512i zero = _mm512_setzero_si512();
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i s = _mm512_sub_epi64(x, y);
+        unsigned g = _mm512_cmplt_epu64_mask(x, y);
+        unsigned p = _mm512_cmpeq_epi64_mask(s, zero);
+        unsigned c = (g << 1) + p + borrow;
+        s = _mm512_mask_add_epi64(s, __mmask8((c ^ p) & 0xff), s, ones);
+        _mm512_storeu_si512(r + i, s);
+        borrow = c >> 8;
+    }
+    return sub_nc(r + i, a + i, b + i, n - i, borrow);
+}
+
+#endif // BIGINT_X86_KERNELS
+
+struct DigitKernels {
+    uint64_t (*add_n)(uint64_t*, const uint64_t*, const uint64_t*, size_t);
+    uint64_t (*sub_n)(uint64_t*, const uint64_t*, const uint64_t*, size_t);
+    int (*cmp_n)(const uint64_t*, const uint64_t*, size_t);
+};
+
+static DigitKernels select_kernels() {
+    DigitKernels k = {add_n_scalar, sub_n_scalar, cmp_n_scalar};
+#ifdef BIGINT_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        k = {add_n_avx2, sub_n_avx2, cmp_n_avx2};
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        k.add_n = add_n_avx512;
+        k.sub_n = sub_n_avx512;
+    }
+#endif
+    return k;
+}
+
+// chosen on first use rather than at static initialization, since a
+// BigInt may be built by another file's static initializer before ours
+static const DigitKernels& kernels() {
+    static const DigitKernels k = select_kernels();
+    return k;
+}
+
+// ^^^ vector kernels ^^^
+
+// below this many digits, the portable loops beat a call through the
+// kernel table
+static const size_t VECTOR_MIN_DIGITS = 8;
+
+// r[0..n) = a[0..n) + b[0..n), returning the carry out
+static uint64_t add_n(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                      const size_t n) {
+    if (n < VECTOR_MIN_DIGITS) {
+        return add_nc(r, a, b, n, 0);
+    }
+    return kernels().add_n(r, a, b, n);
+}
+
+// r[0..n) = a[0..n) - b[0..n), returning the borrow out
+static uint64_t sub_n(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                      const size_t n) {
+    if (n < VECTOR_MIN_DIGITS) {
+        return sub_nc(r, a, b, n, 0);
+    }
+    return kernels().sub_n(r, a, b, n);
+}
+
+// -1, 0 or 1 as a[0..n) is less than, equal to or greater than b[0..n)
+static int cmp_n(const uint64_t* a, const uint64_t* b, const size_t n) {
+    if (n < VECTOR_MIN_DIGITS) {
+        return cmp_n_scalar(a, b, n);
+    }
+    return kernels().cmp_n(a, b, n);
+}
+
+// compare the magnitudes of two normalized nonnegative integers,
+// returning -1, 0 or 1 as lhs is less than, equal to or greater than rhs
+static int compare(const DigitVector& lhs,
+                   const DigitVector& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return lhs.size() < rhs.size() ? -1 : 1;
+    }
+    return cmp_n(lhs.data(), rhs.data(), lhs.size());
+}
+
+// in-place r[0..rn) += a[0..an) for an <= rn, returning the carry out
+static uint64_t add_into(uint64_t* r, const size_t rn,
+                         const uint64_t* a, const size_t an) {
+    assert(an <= rn);
+    uint64_t carry = add_n(r, r, a, an);
+    return add_1(r + an, r + an, rn - an, carry);
+}
+
+// in-place r[0..rn) -= a[0..an) for an <= rn, returning the borrow out
+static uint64_t sub_into(uint64_t* r, const size_t rn,
+                         const uint64_t* a, const size_t an) {
+    assert(an <= rn);
+    uint64_t borrow = sub_n(r, r, a, an);
+    return sub_1(r + an, r + an, rn - an, borrow);
+}
+
+// r[0..n) = a[0..n) << shift for 0 < shift < 64, returning the bits
+// shifted out of the top. Works from the top down, so r may equal a.
+static uint64_t lshift(uint64_t* r, const uint64_t* a, const size_t n,
+                       const unsigned shift) {
+    assert(shift > 0 && shift < 64);
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t out = a[n - 1] >> (64 - shift);
+    for (size_t i = n - 1; i > 0; --i) {
+        r[i] = (a[i] << shift) | (a[i - 1] >> (64 - shift));
+    }
+    r[0] = a[0] << shift;
+    return out;
+}
+
+// in-place a[0..n) >>= shift, for 0 < shift < 64
+static void rshift_in_place(uint64_t* a, const size_t n,
+                            const unsigned shift) {
+    assert(shift > 0 && shift < 64);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        a[i] = (a[i] >> shift) | (a[i + 1] << (64 - shift));
+    }
+    if (n > 0) {
+        a[n - 1] >>= shift;
+    }
+}
+
+// the inverse of an odd d modulo 2^64, by Newton's iteration; d is its
+// own inverse modulo 2^3, and each step doubles the number of correct bits
+static uint64_t inverse_mod_base(const uint64_t d) {
+    assert(d & 1);
+    uint64_t inv = d;
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2 - d * inv;
+    }
+    return inv;
+}
+
+// in-place a[0..n) /= d, where d is known to divide a exactly. Working up
+// from the least-significant digit, each quotient digit is the current
+// digit times the inverse of d modulo 2^64 (Jebelean's exact division), so
+// no hardware division is needed.
+static void divexact_1(uint64_t* a, const size_t n, uint64_t d) {
+    assert(d != 0);
+    unsigned twos = 0;
+    while (!(d & 1)) {
+        d >>= 1;
+        ++twos;
+    }
+    if (twos) {
+        assert((a[0] & ((uint64_t(1) << twos) - 1)) == 0);
+        rshift_in_place(a, n, twos);
+    }
+    const uint64_t inv = inverse_mod_base(d);
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t x = a[i];
+        uint64_t t = x - borrow;
+        borrow = t > x ? 1 : 0;
+        uint64_t q = t * inv;
+        a[i] = q;
+        borrow += uint64_t((uint128_t(q) * d) >> 64);
+    }
+    assert(borrow == 0);
+}
+
+// in-place r[0..n) -= a[0..n) * q, returning the digit borrowed out of the top
+static uint64_t submul_1(uint64_t* r, const uint64_t* a, const size_t n,
+                         const uint64_t q) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        // a q + borrow <= (b - 1)^2 + (b - 1), so the high half is at most
+        // b - 2 and adding the borrow out of the subtraction can't overflow
+        uint128_t p = uint128_t(a[i]) * q + borrow;
+        uint64_t p_lo = uint64_t(p);
+        borrow = uint64_t(p >> 64);
+        uint64_t x = r[i];
+        r[i] = x - p_lo;
+        borrow += x < p_lo ? 1 : 0;
+    }
+    return borrow;
+}
+
+// in-place r[0..n) += a[0..n) * q, returning the digit carried out of the top
+static uint64_t addmul_1(uint64_t* r, const uint64_t* a, const size_t n,
+                         const uint64_t q) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint128_t t = uint128_t(a[i]) * q + r[i] + carry;
+        r[i] = uint64_t(t);
+        carry = uint64_t(t >> 64);
+    }
+    return carry;
+}
+
+// r[0..an+bn) = a[0..an) * b[0..bn), schoolbook style (Knuth's Algorithm M)
+static void mul_basecase(uint64_t* r, const uint64_t* a, const size_t an,
+                         const uint64_t* b, const size_t bn) {
+    std::fill(r, r + an + bn, uint64_t(0));
+    for (size_t j = 0; j < bn; ++j) {
+        // (b - 1)^2 + 2(b - 1) = b^2 - 1, so t never overflows
+        uint64_t k = 0;
+        for (size_t i = 0; i < an; ++i) {
+            uint128_t t = uint128_t(a[i]) * b[j] + r[i + j] + k;
+            r[i + j] = uint64_t(t);
+            k = uint64_t(t >> 64);
+        }
+        r[an + j] = k;
+    }
+}
+
+// r[0..2n) = a[0..n)^2, schoolbook style. Each cross product a[i] a[j]
+// with i < j appears twice in the square, so the triangle of them is formed
+// once and doubled before the diagonal a[i]^2 is added: about half the
+// digit products of mul_basecase.
+static void sqr_basecase(uint64_t* r, const uint64_t* a, const size_t n) {
+    assert(n > 0);
+    std::fill(r, r + 2 * n, uint64_t(0));
+    if (n > 1) {
+        // row i adds into r[2i + 1..i + n) and carries out into r[i + n],
+        // which no earlier row has reached
+        for (size_t i = 0; i + 1 < n; ++i) {
+            r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+        // the cross products sum to less than a^2 / 2, so nothing is lost
+        uint64_t out = lshift(r, r, 2 * n, 1);
+        assert(out == 0);
+        (void)out;
+    }
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint128_t sq = uint128_t(a[i]) * a[i];
+        uint128_t t = uint128_t(r[2 * i]) + uint64_t(sq) + carry;
+        r[2 * i] = uint64_t(t);
+        t = uint128_t(r[2 * i + 1]) + uint64_t(sq >> 64) + uint64_t(t >> 64);
+        r[2 * i + 1] = uint64_t(t);
+        carry = uint64_t(t >> 64);
+    }
+    assert(carry == 0);
+}
+
+// ^^^^^ raw digit-array kernels ^^^^^
+
+// base routine for adding two nonnegative integers
+// REQUIRES: This method assumes that result is an empty vector, which will be
+//           resized to hold the sum.
+static void add(const DigitVector& lhs,
+                const DigitVector& rhs,
+                DigitVector& result) {
+    assert(result.size() == 0);
+    const DigitVector& longer = lhs.size() >= rhs.size() ? lhs : rhs;
+    const DigitVector& shorter = lhs.size() >= rhs.size() ? rhs : lhs;
+    size_t n = shorter.size();
+    result.resize(longer.size() + 1);
+    uint64_t carry = add_n(result.data(), longer.data(), shorter.data(), n);
+    result.back() = add_1(result.data() + n, longer.data() + n,
+                          longer.size() - n, carry);
+    rem_lzeros(result);
+}
+
+// base routine for subtracting two nonnegative integers
+// REQUIRES: This method assumes that result is an empty vector, which will be
+//           resized to hold the difference, and that lhs >= rhs.
+static void subtract(const DigitVector& lhs,
+                     const DigitVector& rhs,
+                     DigitVector& result) {
+    assert(result.size() == 0);
+    assert(lhs.size() >= rhs.size());
+    size_t n = rhs.size();
+    result.resize(lhs.size());
+    uint64_t borrow = sub_n(result.data(), lhs.data(), rhs.data(), n);
+    borrow = sub_1(result.data() + n, lhs.data() + n, lhs.size() - n, borrow);
+    assert(borrow == 0);
+    (void)borrow;
+    rem_lzeros(result);
+}
+
+// in-place a = a * m + c, for single-precision m and c
+static void mul_add_single_precision(DigitVector& a,
+                                     const uint64_t m, const uint64_t c) {
+    uint64_t k = c;
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint128_t t = uint128_t(a[i]) * m + k;
+        a[i] = uint64_t(t);
+        k = uint64_t(t >> 64);
+    }
+    if (k) {
+        a.push_back(k);
+    }
+}
+
+// in-place a = floor(a / v) for single-precision v, returning a mod v
+static uint64_t divide_single_precision(DigitVector& a,
+                                        const uint64_t v) {
+    assert(v != 0);
+    uint64_t r = 0;
+    for (size_t i = a.size(); i-- > 0; ) {
+        uint128_t d_partial = (uint128_t(r) << 64) | a[i];
+        a[i] = uint64_t(d_partial / v);
+        r = uint64_t(d_partial % v);
+    }
+    rem_lzeros(a);
+    return r;
+}
+
+// number of significant bits in a normalized nonnegative integer
+static size_t bit_length(const DigitVector& a) {
+    if (a.back() == 0) {
+        return 0;
+    }
+    return 64 * a.size() - size_t(__builtin_clzll(a.back()));
+}
+
+// a * 2^bits
+static void shift_left(const DigitVector& a, const size_t bits,
+                       DigitVector& result) {
+    const size_t shift_digs = bits / 64;
+    const unsigned shift = unsigned(bits % 64);
+    result.assign(shift_digs + a.size() + 1, 0);
+    std::copy(a.begin(), a.end(), result.begin() + shift_digs);
+    if (shift) {
+        uint64_t* r = result.data() + shift_digs;
+        result.back() = lshift(r, r, a.size(), shift);
+    }
+    rem_lzeros(result);
+}
+
+// floor(a / 2^bits)
+static void shift_right(const DigitVector& a, const size_t bits,
+                        DigitVector& result) {
+    const size_t shift_digs = bits / 64;
+    const unsigned shift = unsigned(bits % 64);
+    if (shift_digs >= a.size()) {
+        result.assign(1, 0);
+        return;
+    }
+    result.assign(a.begin() + shift_digs, a.end());
+    if (shift) {
+        rshift_in_place(result.data(), result.size(), shift);
+    }
+    rem_lzeros(result);
+}
+
+// digits [lo, hi) of a, as a normalized number
+static DigitVector digit_range(const DigitVector& a,
+                                         const size_t lo, const size_t hi) {
+    DigitVector r(1, 0);
+    if (lo < a.size()) {
+        r.assign(a.begin() + lo, a.begin() + std::min(hi, a.size()));
+        rem_lzeros(r);
+    }
+    return r;
+}
+
+// hi * b^n + lo, for lo < b^n
+static DigitVector join(const DigitVector& hi,
+                                  const DigitVector& lo,
+                                  const size_t n) {
+    assert(lo.size() <= n || (lo.size() == 1 && lo[0] == 0));
+    DigitVector r(n + hi.size(), 0);
+    std::copy(lo.begin(), lo.end(), r.begin());
+    std::copy(hi.begin(), hi.end(), r.begin() + n);
+    rem_lzeros(r);
+    return r;
+}
+
+// vvvvv thread pool vvvvv
+//
+// The largest multiplications share their independent sub-products among
+// a pool of worker threads. parallel_for(count, body) runs body(i) for
+// each i in [0, count) on the calling thread and any idle workers, and
+// returns once all have finished, rethrowing the first exception if any
+// failed. Calls nest: a body may call parallel_for itself, and a thread
+// waiting for its indices to finish runs other pending ones meanwhile.
+//
+// A task must not grow a DigitVector that was created on another thread,
+// since that vector allocates from the other thread's memory resource
+// (and an arena can't be shared between threads), so callers size the
+// tasks' outputs up front. A task's own temporaries come from whatever
+// resource is current on the thread that runs it.
+
+class ThreadPool {
+    public:
+        ~ThreadPool() {
+            resize(1);
+        }
+
+        // the number of threads sharing the work, counting the caller
+        unsigned size() const {
+            return threads;
+        }
+
+        void resize(const unsigned new_threads) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers) {
+                t.join();
+            }
+            workers.clear();
+            stopping = false;
+            for (unsigned i = 1; i < new_threads; ++i) {
+                workers.emplace_back([this] { work(); });
+            }
+            threads = std::max(new_threads, 1u);
+        }
+
+        void parallel_for(const size_t count,
+                          const std::function<void(size_t)>& body) {
+            if (threads == 1 || count < 2) {
+                for (size_t i = 0; i < count; ++i) {
+                    body(i);
+                }
+                return;
+            }
+            Job job = {&body, count, 0, 0, nullptr};
+            std::unique_lock<std::mutex> lock(mutex);
+            pending.push_back(&job);
+            wake.notify_all();
+            while (job.done < job.count) {
+                if (!run_one(lock, &job)) {
+                    wake.wait(lock);
+                }
+            }
+            if (job.error) {
+                std::rethrow_exception(job.error);
+            }
+        }
+
+    private:
+        struct Job {
+            const std::function<void(size_t)>* body;
+            size_t count;
+            size_t next; // the first index not yet claimed
+            size_t done; // the number of indices finished
+            std::exception_ptr error;
+        };
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<std::thread> workers;
+        std::deque<Job*> pending; // jobs with indices left to claim
+        bool stopping = false;
+        std::atomic<unsigned> threads{1};
+
+        // claims an index of job, or failing that of the oldest pending
+        // job, and runs it with the lock released; false if there was none
+        bool run_one(std::unique_lock<std::mutex>& lock, Job* job) {
+            if (!job || job->next == job->count) {
+                if (pending.empty()) {
+                    return false;
+                }
+                job = pending.front();
+            }
+            const size_t i = job->next++;
+            if (job->next == job->count) {
+                pending.erase(std::find(pending.begin(), pending.end(), job));
+            }
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                (*job->body)(i);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            if (error && !job->error) {
+                job->error = error;
+            }
+            if (++job->done == job->count) {
+                wake.notify_all();
+            }
+            return true;
+        }
+
+        void work() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                if (!run_one(lock, nullptr)) {
+                    wake.wait(lock);
+                }
+            }
+        }
+};
+
+static ThreadPool& thread_pool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// smaller-operand length, in digits, from which products are split
+// across threads (see BigInt::set_parallel_threshold). A sub-product of
+// this size takes a few hundred microseconds, which dwarfs handing it to
+// another thread.
+static std::atomic<size_t> parallel_min_digits(1000);
+
+static bool run_parallel(const size_t n) {
+    return n >= parallel_min_digits && thread_pool().size() > 1;
+}
+
+// body(i) for i in [0, count), spread across the pool if a product with
+// n digits in its smaller operand is to be parallelized
+template <class F>
+static void run_tasks(const size_t count, const size_t n, const F& body) {
+    if (run_parallel(n)) {
+        thread_pool().parallel_for(count, std::cref(body));
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+    }
+}
+
+// body(lo, hi) over [0, n) split into the given number of contiguous
+// pieces, run across the pool if there is more than one
+template <class F>
+static void for_each_chunk(const size_t n, const size_t chunks,
+                           const F& body) {
+    if (chunks <= 1) {
+        body(size_t(0), n);
+        return;
+    }
+    auto piece = [&](const size_t i) {
+        body(n * i / chunks, n * (i + 1) / chunks);
+    };
+    thread_pool().parallel_for(chunks, std::cref(piece));
+}
+
+// ^^^^^ thread pool ^^^^^
+
+// vvvvv multiplication vvvvv
+
+// Below this many digits in the smaller operand, Karatsuba's extra additions
+// cost more than the partial products it saves. Measured on x86-64 with
+// -O2; the crossover is fairly flat between roughly 24 and 48.
+static const size_t KARATSUBA_THRESHOLD = 32;
+
+// sqr_basecase forms about half the digit products of mul_basecase, which
+// moves the crossover for squares out a little (again fairly flat, between
+// roughly 32 and 64)
+static const size_t SQR_KARATSUBA_THRESHOLD = 48;
+
+// Above these, the three- and four-way Toom-Cook splits below beat
+// Karatsuba's two-way split (again measured, with the smaller operand's
+// length in digits; Toom-Cook's extra linear work makes the crossovers
+// much later than for Karatsuba).
+static const size_t TOOM33_THRESHOLD = 300;
+static const size_t TOOM44_THRESHOLD = 1500;
+
+// and above this the transform-based multiplication wins outright
+static const size_t NTT_THRESHOLD = 7000;
+
+static void mul_n_m(uint64_t* r, const uint64_t* a, const size_t an,
+                    const uint64_t* b, const size_t bn);
+
+// r[0..an+bn) = a * b when a is at least twice as long as b: slice a into
+// pieces of bn digits and accumulate piece * b, so that each recursive
+// product is balanced
+static void mul_unbalanced(uint64_t* r, const uint64_t* a, const size_t an,
+                           const uint64_t* b, const size_t bn) {
+    assert(an >= bn);
+    DigitVector piece(2 * bn);
+    size_t n = std::min(an, bn);
+    mul_n_m(r, a, n, b, bn);
+    std::fill(r + n + bn, r + an + bn, uint64_t(0));
+    for (size_t i = n; i < an; i += bn) {
+        n = std::min(an - i, bn);
+        mul_n_m(piece.data(), a + i, n, b, bn);
+        uint64_t carry = add_into(r + i, an + bn - i, piece.data(), n + bn);
+        assert(carry == 0);
+        (void)carry;
+    }
+}
+
+// r[0..an+bn) = a * b by Karatsuba's method, for an >= bn > ceil(an / 2).
+// With a = a1 B^h + a0 and b = b1 B^h + b0,
+//      a * b = z2 B^2h + (z1 - z2 - z0) B^h + z0
+// where z2 = a1 b1, z0 = a0 b0 and z1 = (a0 + a1)(b0 + b1), i.e. three
+// half-size products instead of four. When a and b are the same operand, all
+// three are squares and a0 + a1 is only formed once.
+static void mul_karatsuba(uint64_t* r, const uint64_t* a, const size_t an,
+                          const uint64_t* b, const size_t bn) {
+    const size_t h = (an + 1) / 2;
+    assert(an >= bn && bn > h);
+    const size_t a1n = an - h;
+    const size_t b1n = bn - h;
+
+    const bool square = a == b && an == bn;
+    DigitVector sa(h + 1), sb(square ? 0 : h + 1), z1(2 * h + 2, 0);
+    sa[h] = add_1(sa.data() + a1n, a + a1n, h - a1n,
+                  add_n(sa.data(), a, a + h, a1n));
+    size_t san = sa[h] ? h + 1 : h;
+    if (!square) {
+        sb[h] = add_1(sb.data() + b1n, b + b1n, h - b1n,
+                      add_n(sb.data(), b, b + h, b1n));
+    }
+    const uint64_t* sbp = square ? sa.data() : sb.data();
+    size_t sbn = square ? san : sb[h] ? h + 1 : h;
+
+    // z0 and z2 go straight into the low and high halves of r; the three
+    // products write to disjoint digits, so they can run in parallel
+    run_tasks(3, bn, [&](const size_t i) {
+        if (i == 0) {
+            mul_n_m(r, a, h, b, h);
+        }
+        else if (i == 1) {
+            mul_n_m(r + 2 * h, a + h, a1n, b + h, b1n);
+        }
+        else {
+            mul_n_m(z1.data(), sa.data(), san, sbp, sbn);
+        }
+    });
+
+    // z1 - z0 - z2 = a0 b1 + a1 b0 is nonnegative, so neither borrows
+    uint64_t borrow = sub_into(z1.data(), z1.size(), r, 2 * h);
+    borrow += sub_into(z1.data(), z1.size(), r + 2 * h, a1n + b1n);
+    assert(borrow == 0);
+
+    // and it fits in what remains of r above B^h
+    size_t z1n = z1.size();
+    while (z1n > 0 && z1[z1n - 1] == 0) {
+        --z1n;
+    }
+    uint64_t carry = add_into(r + h, an + bn - h, z1.data(), z1n);
+    assert(carry == 0);
+    (void)borrow;
+    (void)carry;
+}
+
+// vvv Toom-Cook vvv
+//
+// Toom-Cook generalizes Karatsuba: each operand is split into pieces of k
+// digits and read as a polynomial in x = B^k whose coefficients are the
+// pieces. The product polynomial is found by evaluating both operands at a
+// few small points, multiplying the values pointwise (recursively), and
+// interpolating; its coefficients are then added back together at their
+// offsets. Evaluation at negative points and the interpolation steps can
+// produce negative intermediates, hence SignedDigits.
+//
+// Each level takes a single scratch buffer, cut into fixed slots: one of
+// k + 2 digits per evaluation, one of 2k + 4 per pointwise product, and one
+// more of 2k + 4 for scaled terms. The interpolation then overwrites the
+// products with the coefficients in place, so nothing else is allocated.
+
+// a signed multi-digit value in a slot of cap digits, with magnitude
+// d[0..n) normalized (n == 0 for zero)
+struct SignedDigits {
+    uint64_t* d;
+    size_t n;
+    size_t cap;
+    bool neg;
+};
+
+// the i-th k-digit piece of a[0..an), with leading zeros dropped
+static const uint64_t* toom_piece(const uint64_t* a, const size_t an,
+                                  const size_t i, const size_t k,
+                                  size_t& n) {
+    size_t lo = std::min(an, i * k);
+    n = std::min(an, (i + 1) * k) - lo;
+    while (n > 0 && a[lo + n - 1] == 0) {
+        --n;
+    }
+    return a + lo;
+}
+
+static void s_normalize(SignedDigits& x) {
+    while (x.n > 0 && x.d[x.n - 1] == 0) {
+        --x.n;
+    }
+    if (x.n == 0) {
+        x.neg = false;
+    }
+}
+
+// x = y[0..yn), for nonnegative y
+static void s_assign(SignedDigits& x, const uint64_t* y, const size_t yn) {
+    assert(yn <= x.cap);
+    std::copy(y, y + yn, x.d);
+    x.n = yn;
+    x.neg = false;
+    s_normalize(x);
+}
+
+static void s_assign(SignedDigits& x, const SignedDigits& y) {
+    s_assign(x, y.d, y.n);
+    x.neg = y.neg;
+}
+
+// in-place x += y[0..yn), negated if y_neg is set; y must not overlap x
+static void s_add(SignedDigits& x, const uint64_t* y, const size_t yn,
+                  const bool y_neg) {
+    if (yn == 0) {
+        return;
+    }
+    if (x.n == 0 || x.neg == y_neg) {
+        size_t n = std::max(x.n, yn);
+        assert(n < x.cap);
+        std::fill(x.d + x.n, x.d + n, uint64_t(0));
+        x.d[n] = add_into(x.d, n, y, yn);
+        x.n = n + 1;
+        x.neg = y_neg;
+    }
+    else if (x.n > yn || (x.n == yn && cmp_n(x.d, y, yn) >= 0)) {
+        sub_into(x.d, x.n, y, yn);
+    }
+    else {
+        // |y| > |x|, so x = y - x, which takes y's sign
+        assert(yn <= x.cap);
+        std::fill(x.d + x.n, x.d + yn, uint64_t(0));
+        sub_n(x.d, y, x.d, yn);
+        x.n = yn;
+        x.neg = y_neg;
+    }
+    s_normalize(x);
+}
+
+// in-place x += y, or x -= y if negate_y is set
+static void s_add(SignedDigits& x, const SignedDigits& y,
+                  const bool negate_y = false) {
+    s_add(x, y.d, y.n, y.neg != negate_y);
+}
+
+static void s_sub(SignedDigits& x, const SignedDigits& y) {
+    s_add(x, y, true);
+}
+
+// in-place x *= m for a small m
+static void s_mul_small(SignedDigits& x, const int64_t m) {
+    const uint64_t u = uint64_t(m < 0 ? -m : m);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < x.n; ++i) {
+        uint128_t t = uint128_t(x.d[i]) * u + carry;
+        x.d[i] = uint64_t(t);
+        carry = uint64_t(t >> 64);
+    }
+    if (carry) {
+        assert(x.n < x.cap);
+        x.d[x.n++] = carry;
+    }
+    x.neg = x.neg != (m < 0);
+    s_normalize(x);
+}
+
+// in-place x /= d, where d is known to divide x exactly
+static void s_div_exact(SignedDigits& x, const uint64_t d) {
+    if (x.n > 0) {
+        divexact_1(x.d, x.n, d);
+        s_normalize(x);
+    }
+}
+
+// in-place x -= m * y, for a small m, using t as scratch
+static void s_submul_small(SignedDigits& x, const SignedDigits& y,
+                           const int64_t m, SignedDigits& t) {
+    s_assign(t, y);
+    s_mul_small(t, m);
+    s_sub(x, t);
+}
+
+// in-place o = (e - o) / 2 and e = e - o, i.e. for e = r(x) and o = r(-x),
+// o becomes the odd part (r(x) - r(-x)) / 2 and e the even part
+// (r(x) + r(-x)) / 2
+static void s_even_odd(SignedDigits& e, SignedDigits& o) {
+    s_sub(o, e);
+    o.neg = !o.neg && o.n > 0;
+    s_div_exact(o, 2);
+    s_sub(e, o);
+}
+
+// v = the polynomial whose coefficients are the np k-digit pieces of
+// a[0..an), evaluated at x by Horner's rule
+static void toom_eval(SignedDigits& v, const uint64_t* a, const size_t an,
+                      const size_t np, const size_t k, const int64_t x) {
+    size_t n;
+    const uint64_t* p = toom_piece(a, an, np - 1, k, n);
+    s_assign(v, p, n);
+    for (size_t i = np - 1; i-- > 0; ) {
+        s_mul_small(v, x);
+        p = toom_piece(a, an, i, k, n);
+        s_add(v, p, n, false);
+    }
+}
+
+// split a and b into na and nb pieces of k digits and set p[0..npoints] to
+// the pointwise products of their evaluations at each of the given points,
+// followed by the product of the leading pieces (the "point at infinity"),
+// and t to a spare slot, all carved out of scratch. Squaring evaluates
+// once, and each pointwise product is then itself a square.
+static void toom_pointwise(
+        const uint64_t* a, const size_t an, const size_t na,
+        const uint64_t* b, const size_t bn, const size_t nb,
+        const size_t k, const int64_t* points, const size_t npoints,
+        DigitVector& scratch, SignedDigits* p, SignedDigits& t) {
+    const bool square = a == b && an == bn;
+    const size_t ew = k + 2;
+    const size_t pw = 2 * k + 4;
+    const size_t evals = square ? npoints : 2 * npoints;
+    scratch.resize(evals * ew + (npoints + 2) * pw);
+    uint64_t* slot = scratch.data();
+    SignedDigits ea[6], eb[6];
+    assert(npoints <= 6);
+    for (size_t i = 0; i < npoints; ++i) {
+        ea[i] = SignedDigits{slot, 0, ew, false};
+        slot += ew;
+        toom_eval(ea[i], a, an, na, k, points[i]);
+        if (!square) {
+            eb[i] = SignedDigits{slot, 0, ew, false};
+            slot += ew;
+            toom_eval(eb[i], b, bn, nb, k, points[i]);
+        }
+    }
+    for (size_t i = 0; i <= npoints; ++i) {
+        p[i] = SignedDigits{slot, 0, pw, false};
+        slot += pw;
+    }
+    t = SignedDigits{slot, 0, pw, false};
+
+    // the products write to disjoint slots, so they can run in parallel
+    run_tasks(npoints + 1, bn, [&](const size_t i) {
+        const uint64_t* x;
+        const uint64_t* y;
+        size_t xn, yn;
+        bool neg = false;
+        if (i < npoints) {
+            const SignedDigits& ey = square ? ea[i] : eb[i];
+            x = ea[i].d;
+            xn = ea[i].n;
+            y = ey.d;
+            yn = ey.n;
+            neg = ea[i].neg != ey.neg;
+        }
+        else {
+            x = toom_piece(a, an, na - 1, k, xn);
+            y = square ? x : toom_piece(b, bn, nb - 1, k, yn);
+            yn = square ? xn : yn;
+        }
+        if (xn == 0 || yn == 0) {
+            return;
+        }
+        assert(xn + yn <= p[i].cap);
+        mul_n_m(p[i].d, x, xn, y, yn);
+        p[i].n = xn + yn;
+        p[i].neg = neg;
+        s_normalize(p[i]);
+    });
+}
+
+// r[0..rn) = sum of c[i] x^i for x = B^k. Every coefficient of a product
+// of nonnegative polynomials is nonnegative, and each term fits in r.
+static void toom_recompose(uint64_t* r, const size_t rn,
+                           const SignedDigits* const* c, const size_t nc,
+                           const size_t k) {
+    std::fill(r, r + rn, uint64_t(0));
+    for (size_t i = 0; i < nc; ++i) {
+        assert(!c[i]->neg);
+        if (c[i]->n == 0) {
+            continue;
+        }
+        assert(i * k + c[i]->n <= rn);
+        uint64_t carry = add_into(r + i * k, rn - i * k, c[i]->d, c[i]->n);
+        assert(carry == 0);
+        (void)carry;
+    }
+}
+
+// r[0..an+bn) = a * b for a in three pieces and b in two, i.e. when a is
+// about one and a half times as long as b. The product has degree 3;
+// evaluating at 0, 1, -1 and infinity gives
+//      c0 = r(0), c3 = r(inf),
+//      c2 = (r(1) + r(-1)) / 2 - c0,
+//      c1 = (r(1) - r(-1)) / 2 - c3.
+static void mul_toom32(uint64_t* r, const uint64_t* a, const size_t an,
+                       const uint64_t* b, const size_t bn) {
+    const size_t k = (an + 2) / 3;
+    assert(an > 2 * k && bn > k && bn <= 2 * k);
+    static const int64_t points[] = {0, 1, -1};
+    DigitVector scratch;
+    SignedDigits p[4], t;
+    toom_pointwise(a, an, 3, b, bn, 2, k, points, 3, scratch, p, t);
+    SignedDigits& c0 = p[0];
+    SignedDigits& c3 = p[3];
+
+    s_even_odd(p[1], p[2]);
+    SignedDigits& c2 = p[1];
+    s_sub(c2, c0);
+    SignedDigits& c1 = p[2];
+    s_sub(c1, c3);
+
+    const SignedDigits* c[] = {&c0, &c1, &c2, &c3};
+    toom_recompose(r, an + bn, c, 4, k);
+}
+
+// r[0..an+bn) = a * b by three-way Toom-Cook. The product has degree 4;
+// evaluating at 0, 1, -1, 2 and infinity gives
+//      c0 = r(0), c4 = r(inf),
+//      c2 = (r(1) + r(-1)) / 2 - c0 - c4,
+//      c1 + c3 = (r(1) - r(-1)) / 2,
+//      c1 + 4 c3 = (r(2) - c0 - 4 c2 - 16 c4) / 2,
+// and c1 and c3 follow from the last two.
+static void mul_toom33(uint64_t* r, const uint64_t* a, const size_t an,
+                       const uint64_t* b, const size_t bn) {
+    const size_t k = (an + 2) / 3;
+    assert(an >= bn && bn > 2 * k);
+    static const int64_t points[] = {0, 1, -1, 2};
+    DigitVector scratch;
+    SignedDigits p[5], t;
+    toom_pointwise(a, an, 3, b, bn, 3, k, points, 4, scratch, p, t);
+    SignedDigits& c0 = p[0];
+    SignedDigits& c4 = p[4];
+
+    s_even_odd(p[1], p[2]);
+    SignedDigits& c2 = p[1];
+    s_sub(c2, c0);
+    s_sub(c2, c4);
+    SignedDigits& odd1 = p[2];
+    SignedDigits& odd2 = p[3];
+    s_sub(odd2, c0);
+    s_submul_small(odd2, c2, 4, t);
+    s_submul_small(odd2, c4, 16, t);
+    s_div_exact(odd2, 2);
+    s_sub(odd2, odd1);
+    s_div_exact(odd2, 3);
+    SignedDigits& c3 = p[3];
+    s_sub(odd1, c3);
+    SignedDigits& c1 = p[2];
+
+    const SignedDigits* c[] = {&c0, &c1, &c2, &c3, &c4};
+    toom_recompose(r, an + bn, c, 5, k);
+}
+
+// r[0..an+bn) = a * b by four-way Toom-Cook. The product has degree 6;
+// evaluating at 0, 1, -1, 2, -2, 3 and infinity, the even and odd parts at
+// +-1 and +-2 give
+//      c2 + c4 = (r(1) + r(-1)) / 2 - c0 - c6 = s1,
+//      4 c2 + 16 c4 = (r(2) + r(-2)) / 2 - c0 - 64 c6 = s2,
+//      c1 + c3 + c5 = (r(1) - r(-1)) / 2 = o1,
+//      c1 + 4 c3 + 16 c5 = (r(2) - r(-2)) / 4 = o2,
+// so that c4 = (s2 - 4 s1) / 12, c2 = s1 - c4, and with
+//      c1 + 9 c3 + 81 c5 = (r(3) - c0 - 9 c2 - 81 c4 - 729 c6) / 3 = o3,
+// the odd coefficients follow from d1 = (o2 - o1) / 3 = c3 + 5 c5 and
+// d2 = (o3 - o2) / 5 = c3 + 13 c5.
+static void mul_toom44(uint64_t* r, const uint64_t* a, const size_t an,
+                       const uint64_t* b, const size_t bn) {
+    const size_t k = (an + 3) / 4;
+    assert(an >= bn && bn > 3 * k);
+    static const int64_t points[] = {0, 1, -1, 2, -2, 3};
+    DigitVector scratch;
+    SignedDigits p[7], t;
+    toom_pointwise(a, an, 4, b, bn, 4, k, points, 6, scratch, p, t);
+    SignedDigits& c0 = p[0];
+    SignedDigits& c6 = p[6];
+
+    s_even_odd(p[1], p[2]);
+    s_even_odd(p[3], p[4]);
+    SignedDigits& s1 = p[1];
+    s_sub(s1, c0);
+    s_sub(s1, c6);
+    SignedDigits& s2 = p[3];
+    s_sub(s2, c0);
+    s_submul_small(s2, c6, 64, t);
+    s_submul_small(s2, s1, 4, t);
+    s_div_exact(s2, 12);
+    SignedDigits& c4 = p[3];
+    s_sub(s1, c4);
+    SignedDigits& c2 = p[1];
+
+    SignedDigits& o1 = p[2];
+    SignedDigits& o2 = p[4];
+    s_div_exact(o2, 2);
+    SignedDigits& o3 = p[5];
+    s_sub(o3, c0);
+    s_submul_small(o3, c2, 9, t);
+    s_submul_small(o3, c4, 81, t);
+    s_submul_small(o3, c6, 729, t);
+    s_div_exact(o3, 3);
+    s_sub(o3, o2);
+    s_div_exact(o3, 5);
+    SignedDigits& d2 = p[5];
+    s_sub(o2, o1);
+    s_div_exact(o2, 3);
+    SignedDigits& d1 = p[4];
+    s_sub(d2, d1);
+    s_div_exact(d2, 8);
+    SignedDigits& c5 = p[5];
+    s_submul_small(d1, c5, 5, t);
+    SignedDigits& c3 = p[4];
+    s_sub(o1, c3);
+    s_sub(o1, c5);
+    SignedDigits& c1 = p[2];
+
+    const SignedDigits* c[] = {&c0, &c1, &c2, &c3, &c4, &c5, &c6};
+    toom_recompose(r, an + bn, c, 7, k);
+}
+
+// ^^^ Toom-Cook ^^^
+
+// vvv number-theoretic transform vvv
+//
+// For the largest operands, the digit sequences are convolved with fast
+// Fourier transforms over the integers modulo a prime p (number-theoretic
+// transforms), once for each of three primes just below 2^63. Each is of
+// the form c 2^40 + 1, so roots of unity of every power-of-two order up to
+// 2^40 exist. A coefficient of the convolution of two digit sequences of
+// total length n is less than n b^2 < p1 p2 p3, so it is recovered exactly
+// from its three residues by the Chinese remainder theorem before being
+// carried into radix-b digits. The total cost is O(n log n).
+
+struct NttPrime {
+    uint64_t p;
+    uint64_t g; // generates the multiplicative group modulo p
+};
+
+static const NttPrime NTT_PRIMES[3] = {
+    {0x7ffffe0000000001ULL, 7},
+    {0x7fffef0000000001ULL, 5},
+    {0x7fffe90000000001ULL, 7},
+};
+static const int NTT_MAX_LOG = 40;
+
+// a * b mod p, with a full 128-bit division; only used for setup
+static uint64_t mulmod_1(const uint64_t a, const uint64_t b,
+                         const uint64_t p) {
+    return uint64_t(uint128_t(a) * b % p);
+}
+
+static uint64_t powmod_1(uint64_t a, uint64_t e, const uint64_t p) {
+    uint64_t r = 1;
+    while (e) {
+        if (e & 1) {
+            r = mulmod_1(r, a, p);
+        }
+        a = mulmod_1(a, a, p);
+        e >>= 1;
+    }
+    return r;
+}
+
+// an odd modulus p < 2^63 with what Montgomery multiplication needs:
+// mont_mul(x, y) = x y / 2^64 mod p, which replaces the division by p
+// with two multiplications
+struct NttModulus {
+    uint64_t p;
+    uint64_t p_inv; // p^-1 mod 2^64
+    uint64_t r2;    // 2^128 mod p
+
+    explicit NttModulus(const uint64_t p_in)
+        : p(p_in), p_inv(inverse_mod_base(p_in)) {
+        uint64_t r = uint64_t((uint128_t(1) << 64) % p);
+        r2 = mulmod_1(r, r, p);
+    }
+
+    // requires x y < p 2^64; the result is fully reduced
+    uint64_t mont_mul(const uint64_t x, const uint64_t y) const {
+        uint128_t t = uint128_t(x) * y;
+        // m p agrees with t in the low 64 bits, so t - m p is a multiple
+        // of 2^64 and only the high halves need subtracting
+        uint64_t m = uint64_t(t) * p_inv;
+        uint64_t mp_hi = uint64_t((uint128_t(m) * p) >> 64);
+        uint64_t t_hi = uint64_t(t >> 64);
+        return t_hi >= mp_hi ? t_hi - mp_hi : t_hi - mp_hi + p;
+    }
+
+    // x 2^64 mod p, i.e. x in Montgomery form
+    uint64_t to_mont(const uint64_t x) const {
+        return mont_mul(x, r2);
+    }
+
+    uint64_t add(const uint64_t x, const uint64_t y) const {
+        uint64_t s = x + y;
+        return s >= p ? s - p : s;
+    }
+
+    uint64_t sub(const uint64_t x, const uint64_t y) const {
+        return x >= y ? x - y : x + p - y;
+    }
+};
+
+// powers w^j of an n-th root of unity w, laid out so that the powers of
+// the (2h)-th root w^(n / 2h) used by a length-2h butterfly stage are the
+// contiguous entries [h, 2h), in Montgomery form
+static DigitVector ntt_twiddles(const NttModulus& m,
+                               const uint64_t w, const size_t n) {
+    DigitVector tw(std::max(n, size_t(2)));
+    const uint64_t w_mont = m.to_mont(w);
+    uint64_t x = m.to_mont(1);
+    for (size_t j = 0; j < n / 2; ++j) {
+        tw[n / 2 + j] = x;
+        x = m.mont_mul(x, w_mont);
+    }
+    for (size_t h = n / 4; h >= 1; h /= 2) {
+        for (size_t j = 0; j < h; ++j) {
+            tw[h + j] = tw[2 * h + 2 * j];
+        }
+    }
+    return tw;
+}
+
+// Each stage of a transform of length n is n / 2 butterflies on pairs h
+// apart, in blocks of 2h entries. The stage functions do butterflies
+// [lo, hi), numbered block by block, so that a stage can be split among
+// threads.
+
+// a decimation-in-frequency stage. Twiddles are in Montgomery form, so a
+// plain value times a twiddle stays plain.
+static void ntt_forward_stage(uint64_t* a, const size_t h,
+                              const size_t lo, const size_t hi,
+                              const uint64_t* tw, const NttModulus m) {
+    const unsigned log_h = unsigned(__builtin_ctzll(h));
+    for (size_t t = lo; t < hi; ) {
+        const size_t j0 = t & (h - 1);
+        const size_t j1 = std::min(h, j0 + (hi - t));
+        uint64_t* x = a + ((t >> log_h) << (log_h + 1));
+        uint64_t* y = x + h;
+        for (size_t j = j0; j < j1; ++j) {
+            uint64_t u = x[j];
+            uint64_t v = y[j];
+            x[j] = m.add(u, v);
+            y[j] = m.mont_mul(m.sub(u, v), tw[h + j]);
+        }
+        t += j1 - j0;
+    }
+}
+
+// a decimation-in-time stage
+static void ntt_inverse_stage(uint64_t* a, const size_t h,
+                              const size_t lo, const size_t hi,
+                              const uint64_t* tw, const NttModulus m) {
+    const unsigned log_h = unsigned(__builtin_ctzll(h));
+    for (size_t t = lo; t < hi; ) {
+        const size_t j0 = t & (h - 1);
+        const size_t j1 = std::min(h, j0 + (hi - t));
+        uint64_t* x = a + ((t >> log_h) << (log_h + 1));
+        uint64_t* y = x + h;
+        for (size_t j = j0; j < j1; ++j) {
+            uint64_t u = x[j];
+            uint64_t v = m.mont_mul(y[j], tw[h + j]);
+            x[j] = m.add(u, v);
+            y[j] = m.sub(u, v);
+        }
+        t += j1 - j0;
+    }
+}
+
+// in-place forward transform: natural-order input, bit-reversed output,
+// with each stage split into the given number of chunks
+static void ntt_forward(uint64_t* a, const size_t n, const uint64_t* tw,
+                        const NttModulus& m, const size_t chunks) {
+    for (size_t h = n / 2; h >= 1; h /= 2) {
+        for_each_chunk(n / 2, chunks, [&](const size_t lo, const size_t hi) {
+            ntt_forward_stage(a, h, lo, hi, tw, m);
+        });
+    }
+}
+
+// in-place inverse transform (without the 1/n factor): bit-reversed
+// input, natural-order output
+static void ntt_inverse(uint64_t* a, const size_t n, const uint64_t* tw,
+                        const NttModulus& m, const size_t chunks) {
+    for (size_t h = 1; h < n; h *= 2) {
+        for_each_chunk(n / 2, chunks, [&](const size_t lo, const size_t hi) {
+            ntt_inverse_stage(a, h, lo, hi, tw, m);
+        });
+    }
+}
+
+// the cyclic convolution of a and b modulo m.p, of length n, a power of two
+// at least an + bn - 1, leaving plain residues in out. A square needs only
+// one forward transform.
+static void ntt_convolve(DigitVector& out, const NttPrime& prime,
+                         const uint64_t* a, const size_t an,
+                         const uint64_t* b, const size_t bn,
+                         const size_t n, const size_t chunks) {
+    assert(out.size() == n);
+    const NttModulus m(prime.p);
+    const bool square = a == b && an == bn;
+    DigitVector fb(square ? 0 : n, 0);
+    std::fill(out.begin(), out.end(), uint64_t(0));
+    for (size_t i = 0; i < an; ++i) {
+        out[i] = a[i] % m.p;
+    }
+    for (size_t i = 0; i < bn && !square; ++i) {
+        fb[i] = b[i] % m.p;
+    }
+
+    const uint64_t w = powmod_1(prime.g, (m.p - 1) / n, m.p);
+    DigitVector tw = ntt_twiddles(m, w, n);
+    ntt_forward(out.data(), n, tw.data(), m, chunks);
+    if (!square) {
+        ntt_forward(fb.data(), n, tw.data(), m, chunks);
+    }
+    const uint64_t* fbp = square ? out.data() : fb.data();
+    // the pointwise Montgomery products pick up a factor of 2^-64, which
+    // is cancelled along with the 1/n by the final scaling
+    for_each_chunk(n, chunks, [&](const size_t lo, const size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            out[i] = m.mont_mul(out[i], fbp[i]);
+        }
+    });
+    const uint64_t w_inv = powmod_1(w, m.p - 2, m.p);
+    tw = ntt_twiddles(m, w_inv, n);
+    ntt_inverse(out.data(), n, tw.data(), m, chunks);
+    const uint64_t scale = mulmod_1(m.r2, powmod_1(n % m.p, m.p - 2, m.p),
+                                    m.p);
+    for_each_chunk(n, chunks, [&](const size_t lo, const size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            out[i] = m.mont_mul(out[i], scale);
+        }
+    });
+}
+
+// r[0..an+bn) = a * b by number-theoretic transforms
+static void mul_ntt(uint64_t* r, const uint64_t* a, const size_t an,
+                    const uint64_t* b, const size_t bn) {
+    const size_t len = an + bn - 1;
+    size_t n = 1;
+    int log_n = 0;
+    while (n < len) {
+        n *= 2;
+        ++log_n;
+    }
+    assert(log_n <= NTT_MAX_LOG);
+    (void)log_n;
+
+    // the three convolutions are independent, and with threads to spare
+    // each splits its transforms as well (the CRT below stays serial)
+    DigitVector res[3];
+    for (int i = 0; i < 3; ++i) {
+        res[i].resize(n);
+    }
+    const size_t chunks = run_parallel(bn) ? thread_pool().size() : 1;
+    run_tasks(3, bn, [&](const size_t i) {
+        ntt_convolve(res[i], NTT_PRIMES[i], a, an, b, bn, n, chunks);
+    });
+
+    // Garner's form of the CRT: with x = r1 + p1 t1 + p1 p2 t2,
+    //      t1 = (r2 - r1) / p1 mod p2,
+    //      t2 = (r3 - r1 - p1 t1) / (p1 p2) mod p3,
+    // where the constant factors are kept in Montgomery form
+    const uint64_t p1 = NTT_PRIMES[0].p;
+    const uint64_t p2 = NTT_PRIMES[1].p;
+    const uint64_t p3 = NTT_PRIMES[2].p;
+    const NttModulus m2(p2), m3(p3);
+    const uint64_t p1_inv_m2 = m2.to_mont(powmod_1(p1 % p2, p2 - 2, p2));
+    const uint64_t p1_m3 = m3.to_mont(p1 % p3);
+    const uint64_t p1p2_inv_m3 = m3.to_mont(
+        powmod_1(mulmod_1(p1 % p3, p2 % p3, p3), p3 - 2, p3));
+    const uint128_t p1p2 = uint128_t(p1) * p2;
+    const uint64_t p1p2_lo = uint64_t(p1p2);
+    const uint64_t p1p2_hi = uint64_t(p1p2 >> 64);
+
+    // running carry, below 2^128 since every x is below 2^190
+    uint128_t carry = 0;
+    const size_t rn = an + bn;
+    for (size_t k = 0; k < rn; ++k) {
+        if (k >= len) {
+            r[k] = uint64_t(carry);
+            carry >>= 64;
+            continue;
+        }
+        uint64_t r1 = res[0][k];
+        uint64_t r2 = res[1][k];
+        uint64_t r3 = res[2][k];
+        uint64_t t1 = m2.mont_mul(m2.sub(r2, r1 >= p2 ? r1 - p2 : r1),
+                                  p1_inv_m2);
+        uint64_t x12_m3 = m3.add(r1 >= p3 ? r1 - p3 : r1,
+                                 m3.mont_mul(t1, p1_m3));
+        uint64_t t2 = m3.mont_mul(m3.sub(r3, x12_m3), p1p2_inv_m3);
+
+        // x = r1 + p1 t1 + p1p2 t2, as three digits x0, x1, x2
+        uint128_t x12 = uint128_t(p1) * t1 + r1;
+        uint128_t lo = uint128_t(p1p2_lo) * t2 + uint64_t(x12);
+        uint128_t hi = uint128_t(p1p2_hi) * t2 + uint64_t(x12 >> 64) +
+                       uint64_t(lo >> 64);
+        uint64_t x0 = uint64_t(lo);
+
+        // add x to the carry and emit the low digit
+        uint128_t s = uint128_t(x0) + uint64_t(carry);
+        r[k] = uint64_t(s);
+        carry = (carry >> 64) + hi + uint64_t(s >> 64);
+    }
+    assert(carry == 0);
+}
+
+// ^^^ number-theoretic transform ^^^
+
+// r[0..an+bn) = a[0..an) * b[0..bn), choosing an algorithm by operand size:
+// schoolbook for small operands, then Karatsuba, then Toom-Cook, then
+// number-theoretic transforms, after first slicing the longer operand if the
+// lengths are very different. Passing the same operand twice (a == b and
+// an == bn) selects the squaring variant of each of these.
+// r must not overlap a or b.
+static void mul_n_m(uint64_t* r, const uint64_t* a, const size_t an,
+                    const uint64_t* b, const size_t bn) {
+    if (an < bn) {
+        mul_n_m(r, b, bn, a, an);
+    }
+    else if (a == b && an == bn && bn < SQR_KARATSUBA_THRESHOLD) {
+        STATS_ALGORITHM(SQR_BASECASE);
+        sqr_basecase(r, a, an);
+    }
+    else if (bn < KARATSUBA_THRESHOLD) {
+        STATS_ALGORITHM(MUL_BASECASE);
+        mul_basecase(r, a, an, b, bn);
+    }
+    else if (bn >= NTT_THRESHOLD) {
+        STATS_ALGORITHM(MUL_NTT);
+        mul_ntt(r, a, an, b, bn);
+    }
+    else if (bn <= (an + 1) / 2) {
+        STATS_ALGORITHM(MUL_UNBALANCED);
+        mul_unbalanced(r, a, an, b, bn);
+    }
+    else if (bn < TOOM33_THRESHOLD) {
+        STATS_ALGORITHM(MUL_KARATSUBA);
+        mul_karatsuba(r, a, an, b, bn);
+    }
+    else if (bn <= 2 * ((an + 2) / 3)) {
+        // between one and a half and two times as long
+        STATS_ALGORITHM(MUL_TOOM32);
+        mul_toom32(r, a, an, b, bn);
+    }
+    else if (bn < TOOM44_THRESHOLD || bn <= 3 * ((an + 3) / 4)) {
+        STATS_ALGORITHM(MUL_TOOM33);
+        mul_toom33(r, a, an, b, bn);
+    }
+    else {
+        STATS_ALGORITHM(MUL_TOOM44);
+        mul_toom44(r, a, an, b, bn);
+    }
+}
+
+// ^^^^^ multiplication ^^^^^
+
+// base routine for mutliplying two nonnegative integers
+// REQUIRES: This method assumes that result is an empty vector, which will be
+//           resized to hold the product.
+static void multiply(const DigitVector& lhs,
+                     const DigitVector& rhs,
+                     DigitVector& result) {
+    assert(result.size() == 0);
+    result.resize(lhs.size() + rhs.size());
+    mul_n_m(result.data(), lhs.data(), lhs.size(), rhs.data(), rhs.size());
+    rem_lzeros(result);
+}
+
+// result = b^exp for nonnegative b, with 0^0 = 1, by left-to-right binary
+// exponentiation: square for every bit of exp below the top one, and
+// multiply by b where it is set. b^exp has at most exp * bit_length(b)
+// bits, so both buffers are sized for that (plus some slack, as a
+// product's buffer can be a digit longer than its value) and the partial
+// powers alternate between them without further allocation.
+// REQUIRES: result is not b
+static void power(const DigitVector& b, const unsigned exp,
+                  DigitVector& result) {
+    assert(&result != &b);
+    if (exp == 0) {
+        result.assign(1, 1);
+        return;
+    }
+    if ((b.size() == 1 && b[0] <= 1) || exp == 1) {
+        result = b;
+        return;
+    }
+    const size_t bound = (bit_length(b) * exp + 63) / 64;
+    DigitVector& acc = result;
+    DigitVector tmp(bound + 2);
+    acc.assign(bound + 2, 0);
+    std::copy(b.begin(), b.end(), acc.begin());
+    size_t n = b.size();
+
+    unsigned bit = 0;
+    while (exp >> (bit + 1)) {
+        ++bit;
+    }
+    while (bit-- > 0) {
+        mul_n_m(tmp.data(), acc.data(), n, acc.data(), n);
+        n *= 2;
+        if ((exp >> bit) & 1) {
+            while (tmp[n - 1] == 0) {
+                --n;
+            }
+            if (b.size() == 1) {
+                // a one-digit base is applied in place
+                tmp[n] = addmul_1(tmp.data(), tmp.data(), n, b[0] - 1);
+                ++n;
+            }
+            else {
+                acc.swap(tmp);
+                mul_n_m(tmp.data(), acc.data(), n, b.data(), b.size());
+                n += b.size();
+            }
+        }
+        acc.swap(tmp);
+        while (acc[n - 1] == 0) {
+            --n;
+        }
+    }
+    acc.resize(n);
+}
+
+// base routine for dividing two nonnegative integers
+// from Knuth, The Art of Computer Programming (Seminumerical Algorithms):
+//
+// given nonnegative integers
+//      u = (u_{m+n-1}...u_{0})_{b}
+//      and
+//      v = (v{n-1}...v_{0})_{b},
+// where the leading digit of v n.e. 0 and n > 1,
+// this recipe forms the radix-b quotient
+//      floor(u / v) = (q_{m}...q_{0})_{b}
+// and the remainder
+//      u mod v = (r_{n-1}...r_{0})_{b}.
+//
+// (Algorithm D.) After shifting u and v left until the top bit of v is set
+// (D1), each quotient digit is estimated from the top two digits of the
+// current remainder and the top digit of v, then corrected using the second
+// digit of v (D3), after which the estimate is at most one too large. The
+// digit times v is subtracted from the remainder (D4), and in the rare case
+// that this goes negative, v is added back and the digit decremented (D6).
+// Finally the remainder is shifted back (D8).
+static void divide_knuth(const DigitVector& lhs,
+                         const DigitVector& rhs,
+                         DigitVector& quotient,
+                         DigitVector& remainder) {
+    const size_t n = rhs.size();
+    assert(n > 1 && lhs.size() >= n && rhs.back() != 0);
+    const size_t m = lhs.size() - n;
+
+    // D1. normalize
+    const unsigned s = unsigned(__builtin_clzll(rhs.back()));
+    DigitVector v(rhs);
+    DigitVector u(lhs);
+    u.push_back(0);
+    if (s) {
+        lshift(v.data(), v.data(), n, s);
+        u[m + n] = lshift(u.data(), u.data(), m + n, s);
+    }
+
+    const uint64_t v1 = v[n - 1];
+    const uint64_t v2 = v[n - 2];
+    quotient.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0; ) {
+        // D3. calculate qhat, which can start out as large as b + 1
+        uint128_t num = (uint128_t(u[j + n]) << 64) | u[j + n - 1];
+        uint128_t qhat = num / v1;
+        uint128_t rhat = num % v1;
+        while (qhat >> 64 ||
+               qhat * v2 > ((rhat << 64) | u[j + n - 2])) {
+            --qhat;
+            rhat += v1;
+            if (rhat >> 64) {
+                break;
+            }
+        }
+
+        // D4. multiply and subtract
+        uint64_t borrow = submul_1(u.data() + j, v.data(), n, uint64_t(qhat));
+        uint64_t top = u[j + n];
+        u[j + n] = top - borrow;
+
+        // D5, D6. test remainder, and add back if it went negative; the
+        // carry out of the addition cancels the borrow
+        if (top < borrow) {
+            --qhat;
+            u[j + n] += add_n(u.data() + j, u.data() + j, v.data(), n);
+        }
+        quotient[j] = uint64_t(qhat);
+    }
+
+    // D8. unnormalize
+    remainder.assign(u.begin(), u.begin() + n);
+    if (s) {
+        rshift_in_place(remainder.data(), n, s);
+    }
+    rem_lzeros(quotient);
+    rem_lzeros(remainder);
+}
+
+// floor(lhs / rhs) and lhs mod rhs for nonnegative lhs and positive rhs,
+// in quadratic time
+static void divide_schoolbook(const DigitVector& lhs,
+                              const DigitVector& rhs,
+                              DigitVector& quotient,
+                              DigitVector& remainder) {
+    if (compare(lhs, rhs) < 0) {
+        quotient.assign(1, 0);
+        remainder = lhs;
+    }
+    else if (rhs.size() == 1) {
+        STATS_ALGORITHM(DIV_SINGLE);
+        quotient = lhs;
+        remainder.assign(1, divide_single_precision(quotient, rhs[0]));
+    }
+    else {
+        STATS_ALGORITHM(DIV_KNUTH);
+        divide_knuth(lhs, rhs, quotient, remainder);
+    }
+}
+
+// vvv Burnikel-Ziegler vvv
+//
+// Burnikel and Ziegler's recursive division ("Fast Recursive Division",
+// 1998) divides a 2n-digit number by an n-digit one with two divisions of
+// 3/2 n digits by n digits, each of which is one recursive 2n/n division
+// of half the size plus one multiplication of half the size. Its cost is
+// therefore within a log factor of the multiplication it uses, instead of
+// quadratic.
+
+// Below this many digits in the divisor, or in the quotient, Algorithm D
+// is faster (measured as for the multiplication thresholds)
+static const size_t BZ_THRESHOLD = 50;
+
+static void div_2n_1n(const DigitVector& a,
+                      const DigitVector& b, const size_t n,
+                      DigitVector& quotient,
+                      DigitVector& remainder);
+
+// [a12, a3] / [b1, b2], where each of a3, b1 and b2 is a block of n digits,
+// a12 is two blocks and a12 < [b1, b2] (the paper's Algorithm 2). The
+// quotient is estimated by dividing a12 by b1 alone, which can only be too
+// large, and by at most 2.
+static void div_3n_2n(const DigitVector& a12,
+                      const DigitVector& a3,
+                      const DigitVector& b, const size_t n,
+                      DigitVector& quotient,
+                      DigitVector& remainder) {
+    const DigitVector b1 = digit_range(b, n, 2 * n);
+    const DigitVector b2 = digit_range(b, 0, n);
+    DigitVector r1, t;
+    if (compare(digit_range(a12, n, 2 * n), b1) < 0) {
+        div_2n_1n(a12, b1, n, quotient, r1);
+    }
+    else {
+        // the estimate is b^n - 1, leaving a12 - (b^n - 1) b1 =
+        // a12 + b1 - b1 b^n
+        quotient.assign(n, ~uint64_t(0));
+        add(a12, b1, t);
+        subtract(t, join(b1, DigitVector(1, 0), n), r1);
+    }
+
+    DigitVector d;
+    multiply(quotient, b2, d);
+    DigitVector rhat = join(r1, a3, n);
+    const DigitVector one(1, 1);
+    while (compare(rhat, d) < 0) {
+        t.clear();
+        subtract(quotient, one, t);
+        quotient.swap(t);
+        t.clear();
+        add(rhat, b, t);
+        rhat.swap(t);
+    }
+    remainder.clear();
+    subtract(rhat, d, remainder);
+}
+
+// a / b, where b has exactly n digits with the top bit set and a < b^n b
+// (the paper's Algorithm 1)
+static void div_2n_1n(const DigitVector& a,
+                      const DigitVector& b, const size_t n,
+                      DigitVector& quotient,
+                      DigitVector& remainder) {
+    if (n % 2 || n < BZ_THRESHOLD) {
+        divide_schoolbook(a, b, quotient, remainder);
+        return;
+    }
+    // a is four blocks of h digits, [a1, a2, a3, a4]
+    const size_t h = n / 2;
+    DigitVector q1, q2, r;
+    div_3n_2n(digit_range(a, 2 * h, 4 * h), digit_range(a, h, 2 * h), b, h,
+              q1, r);
+    div_3n_2n(r, digit_range(a, 0, h), b, h, q2, remainder);
+    quotient = join(q1, q2, h);
+}
+
+// floor(lhs / rhs) and lhs mod rhs by Burnikel-Ziegler. Both are first
+// shifted left so that rhs fills a whole number of digits n, with its top
+// bit set, where n halves evenly down to below BZ_THRESHOLD; lhs is then
+// divided one block of n digits at a time, like a long division in
+// radix b^n.
+static void divide_bz(const DigitVector& lhs,
+                      const DigitVector& rhs,
+                      DigitVector& quotient,
+                      DigitVector& remainder) {
+    size_t m = 1;
+    while (rhs.size() / m >= BZ_THRESHOLD) {
+        m *= 2;
+    }
+    const size_t n = (rhs.size() + m - 1) / m * m;
+    const size_t sigma = 64 * n - bit_length(rhs);
+    DigitVector a, b;
+    shift_left(lhs, sigma, a);
+    shift_left(rhs, sigma, b);
+
+    // the number of blocks in a, leaving the top bit of the top block
+    // clear so that the top block is less than b
+    const size_t block_bits = 64 * n;
+    const size_t t = std::max(size_t(2),
+                              (bit_length(a) + block_bits) / block_bits);
+
+    quotient.assign((t - 1) * n, 0);
+    DigitVector z = digit_range(a, (t - 2) * n, t * n);
+    for (size_t i = t - 1; i-- > 0; ) {
+        DigitVector qi, ri;
+        div_2n_1n(z, b, n, qi, ri);
+        std::copy(qi.begin(), qi.end(), quotient.begin() + i * n);
+        if (i > 0) {
+            z = join(ri, digit_range(a, (i - 1) * n, i * n), n);
+        }
+        else {
+            shift_right(ri, sigma, remainder);
+        }
+    }
+    rem_lzeros(quotient);
+}
+
+// ^^^ Burnikel-Ziegler ^^^
+
+// floor(lhs / rhs) and lhs mod rhs for nonnegative lhs and positive rhs
+static void divide(const DigitVector& lhs,
+                   const DigitVector& rhs,
+                   DigitVector& quotient,
+                   DigitVector& remainder) {
+    if (rhs.size() >= BZ_THRESHOLD &&
+        lhs.size() >= rhs.size() + BZ_THRESHOLD) {
+        STATS_ALGORITHM(DIV_BURNIKEL_ZIEGLER);
+        divide_bz(lhs, rhs, quotient, remainder);
+    }
+    else {
+        divide_schoolbook(lhs, rhs, quotient, remainder);
+    }
+}
+
+// vvvvv radix conversion vvvvv
+//
+// Converting between radix 2^64 and decimal one DEC_CHUNK at a time is
+// quadratic. For long numbers, both directions instead split recursively
+// on the powers 10^(19 2^k): a number is its high part times such a power
+// plus its low part, so parsing multiplies the two halves back together and
+// printing divides them apart, using the fast multiplication and division
+// above.
+
+// below this many digits (of radix 2^64), convert a chunk at a time
+static const size_t DEC_CONVERT_THRESHOLD = 30;
+
+// DEC_CHUNK^(2^k), for k in [0, count)
+static std::vector<DigitVector> decimal_powers(const size_t count) {
+    std::vector<DigitVector> powers;
+    powers.push_back(DigitVector(1, DEC_CHUNK));
+    while (powers.size() < count) {
+        DigitVector sq;
+        multiply(powers.back(), powers.back(), sq);
+        powers.push_back(sq);
+    }
+    return powers;
+}
+
+// the eight bytes at s as a word with s[0] in the low byte
+static uint64_t load_8_chars(const char* s) {
+    uint64_t v;
+    std::memcpy(&v, s, 8);
+    return LITTLE_ENDIAN_HOST ? v : __builtin_bswap64(v);
+}
+
+// whether s[0..8) are all decimal digits: every byte's high nibble must be
+// 3, and stay 3 when 6 is added (so the low nibble is at most 9)
+static bool is_8_digits(const char* s) {
+    const uint64_t v = load_8_chars(s);
+    const uint64_t high = 0xF0F0F0F0F0F0F0F0ULL;
+    return ((v & high) | (((v + 0x0606060606060606ULL) & high) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+static bool all_decimal_digits(const char* s, const size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        if (!is_8_digits(s + i)) {
+            return false;
+        }
+    }
+    for (; i < len; ++i) {
+        if (s[i] < '0' || s[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the value of the eight decimal digits s[0..8) in three multiplications
+// rather than eight: adjacent digits are combined into pairs in every other
+// byte, pairs into fours in every other 16 bits, then fours into eight
+static uint64_t parse_8_digits(const char* s) {
+    uint64_t v = load_8_chars(s) - 0x3030303030303030ULL;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+    return (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+}
+
+// the value of the decimal digits s[0..len), consuming them most-significant
+// first, DEC_CHUNK_DIGITS at a time, with the first chunk taking up any
+// remainder so that every later chunk is full. A full chunk is read as two
+// runs of eight digits and three more. Each chunk adds less than one digit
+// of radix 2^64, so the result is sized once up front.
+static void from_decimal_basecase(const char* s, const size_t len,
+                                  DigitVector& result) {
+    result.reserve(len / DEC_CHUNK_DIGITS + 1);
+    result.assign(1, 0);
+    size_t i = 0;
+    size_t chunk_len = len % DEC_CHUNK_DIGITS;
+    if (chunk_len == 0) {
+        chunk_len = DEC_CHUNK_DIGITS;
+    }
+    while (i < len) {
+        uint64_t chunk = 0;
+        uint64_t scale = DEC_CHUNK;
+        if (chunk_len == DEC_CHUNK_DIGITS) {
+            const char* c = s + i;
+            chunk = parse_8_digits(c) * 100000000000ULL +
+                    parse_8_digits(c + 8) * 1000 +
+                    uint64_t(c[16] - '0') * 100 +
+                    uint64_t(c[17] - '0') * 10 + uint64_t(c[18] - '0');
+        }
+        else {
+            scale = 1;
+            for (size_t j = 0; j < chunk_len; ++j) {
+                chunk = chunk * 10 + uint64_t(s[i + j] - '0');
+                scale *= 10;
+            }
+        }
+        mul_add_single_precision(result, scale, chunk);
+        i += chunk_len;
+        chunk_len = DEC_CHUNK_DIGITS;
+    }
+    rem_lzeros(result);
+}
+
+// the value of the decimal digits s[0..len), where powers holds every
+// DEC_CHUNK^(2^k) with 19 2^k < len
+static void from_decimal(const char* s, const size_t len,
+                         const std::vector<DigitVector>& powers,
+                         DigitVector& result) {
+    if (len <= DEC_CONVERT_THRESHOLD * DEC_CHUNK_DIGITS) {
+        from_decimal_basecase(s, len, result);
+        return;
+    }
+    // split off the largest low part of 19 2^k digits
+    size_t k = 0;
+    while (DEC_CHUNK_DIGITS << (k + 1) < len) {
+        ++k;
+    }
+    const size_t low_len = DEC_CHUNK_DIGITS << k;
+    DigitVector high, low, t;
+    from_decimal(s, len - low_len, powers, high);
+    from_decimal(s + len - low_len, low_len, powers, low);
+    multiply(high, powers[k], t);
+    result.clear();
+    add(t, low, result);
+}
+
+// the value of the decimal digits s[0..len), building the powers that
+// from_decimal needs only for numbers long enough to split
+static void from_decimal(const char* s, const size_t len,
+                         DigitVector& result) {
+    if (len <= DEC_CONVERT_THRESHOLD * DEC_CHUNK_DIGITS) {
+        from_decimal_basecase(s, len, result);
+        return;
+    }
+    size_t count = 0;
+    while (DEC_CHUNK_DIGITS << count < len) {
+        ++count;
+    }
+    from_decimal(s, len, decimal_powers(count), result);
+}
+
+// Text headed for a stream is handed to it in blocks of about this many
+// characters rather than built up whole.
+static const size_t OUTPUT_BLOCK = size_t(1) << 16;
+
+// write out to os and empty it once it holds a block, if os is set
+static void flush_block(std::string& out, std::ostream* os) {
+    if (os && out.size() >= OUTPUT_BLOCK) {
+        os->write(out.data(), std::streamsize(out.size()));
+        out.clear();
+    }
+}
+
+// append the decimal digits of u to out, left-padded with zeros to pad
+// digits if pad is nonzero (u must then be less than 10^pad)
+static void to_decimal_basecase(DigitVector u, const size_t pad,
+                                std::string& out) {
+    // peel off DEC_CHUNK_DIGITS decimal digits at a time by repeated
+    // single-precision division, least-significant chunk first (u has
+    // fewer than DEC_CONVERT_THRESHOLD digits, so fewer chunks than that)
+    uint64_t chunks[DEC_CONVERT_THRESHOLD];
+    size_t count = 0;
+    while (u.size() > 1 || u[0] >= DEC_CHUNK) {
+        assert(count < DEC_CONVERT_THRESHOLD);
+        chunks[count++] = divide_single_precision(u, DEC_CHUNK);
+    }
+    char buf[DEC_CHUNK_DIGITS];
+    char* first = buf + DEC_CHUNK_DIGITS;
+    uint64_t top = u[0];
+    do {
+        *--first = char('0' + top % 10);
+        top /= 10;
+    } while (top);
+    const size_t len = size_t(buf + DEC_CHUNK_DIGITS - first) +
+                       count * DEC_CHUNK_DIGITS;
+    assert(pad == 0 || len <= pad);
+    if (len < pad) {
+        out.append(pad - len, '0');
+    }
+    out.append(first, buf + DEC_CHUNK_DIGITS);
+    for (size_t i = count; i-- > 0; ) {
+        uint64_t chunk = chunks[i];
+        for (size_t j = DEC_CHUNK_DIGITS; j-- > 0; ) {
+            buf[j] = char('0' + chunk % 10);
+            chunk /= 10;
+        }
+        out.append(buf, DEC_CHUNK_DIGITS);
+    }
+}
+
+// append the decimal digits of u < powers[k]^2 to out, padded as above,
+// passing full blocks on to os if it is set
+static void to_decimal(const DigitVector& u,
+                       const std::vector<DigitVector>& powers,
+                       const size_t k, const size_t pad, std::string& out,
+                       std::ostream* os = nullptr) {
+    if (u.size() < DEC_CONVERT_THRESHOLD || k == 0) {
+        to_decimal_basecase(u, pad, out);
+        flush_block(out, os);
+        return;
+    }
+    const size_t low_len = DEC_CHUNK_DIGITS << k;
+    if (pad == 0 && compare(u, powers[k]) < 0) {
+        // no high part, and no zeros to pad it with
+        to_decimal(u, powers, k - 1, 0, out, os);
+        return;
+    }
+    DigitVector high, low;
+    divide(u, powers[k], high, low);
+    to_decimal(high, powers, k - 1, pad ? pad - low_len : 0, out, os);
+    to_decimal(low, powers, k - 1, low_len, out, os);
+}
+
+// append the decimal digits of u to out, as to_decimal
+static void write_decimal(const DigitVector& u, std::string& out,
+                          std::ostream* os = nullptr) {
+    if (u.size() < DEC_CONVERT_THRESHOLD) {
+        to_decimal_basecase(u, 0, out);
+        return;
+    }
+    // the largest DEC_CHUNK^(2^k) not exceeding u; squaring stops once the
+    // square certainly has more digits than u
+    std::vector<DigitVector> powers = decimal_powers(1);
+    while (2 * powers.back().size() - 1 <= u.size()) {
+        DigitVector sq;
+        multiply(powers.back(), powers.back(), sq);
+        powers.push_back(sq);
+    }
+    size_t k = powers.size() - 1;
+    while (k > 0 && compare(powers[k], u) > 0) {
+        --k;
+    }
+    to_decimal(u, powers, k, 0, out, os);
+}
+
+// append the hexadecimal (bits == 4) or octal (bits == 3) digits of u to
+// out, passing full blocks on to os if it is set
+static void write_power_of_two_base(const DigitVector& u,
+                                    const unsigned bits, const bool upper,
+                                    std::string& out,
+                                    std::ostream* os = nullptr) {
+    const char* symbols = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    const size_t count = std::max<size_t>(1,
+                                          (bit_length(u) + bits - 1) / bits);
+    for (size_t i = count; i-- > 0; ) {
+        const size_t pos = i * bits;
+        const size_t word = pos / 64;
+        const unsigned shift = unsigned(pos % 64);
+        uint64_t v = u[word] >> shift;
+        if (shift + bits > 64 && word + 1 < u.size()) {
+            v |= u[word + 1] << (64 - shift);
+        }
+        out.push_back(symbols[v & mask]);
+        if (i % OUTPUT_BLOCK == 0) {
+            flush_block(out, os);
+        }
+    }
+}
+
+// ^^^^^ radix conversion ^^^^^
+
+// vvvvv stream input vvvvv
+//
+// operator>> converts digits as they are read rather than collecting the
+// text first. Hexadecimal and octal digits map straight to bits; decimal
+// digits are gathered into blocks that are converted one at a time and
+// then combined as the recursive conversion above would.
+
+// the value of the character c as a digit in the given base, or -1
+static int digit_value(const int c, const int base) {
+    int v = -1;
+    if (c >= '0' && c <= '9') {
+        v = c - '0';
+    }
+    else if (c >= 'a' && c <= 'f') {
+        v = c - 'a' + 10;
+    }
+    else if (c >= 'A' && c <= 'F') {
+        v = c - 'A' + 10;
+    }
+    return v < base ? v : -1;
+}
+
+// the digits of this many DEC_CHUNKs make up one block
+static const size_t STREAM_BLOCK_CHUNKS = 16;
+static const size_t STREAM_BLOCK_DIGITS =
+    STREAM_BLOCK_CHUNKS * DEC_CHUNK_DIGITS;
+
+// Each full block of decimal digits becomes a part, and two parts of the
+// same length are merged as soon as both exist, as in a binary counter.
+// Every merge is then a balanced multiplication, and only one block of
+// text is held at a time.
+class DecimalReader {
+    public:
+        void push(const char c) {
+            block[used++] = c;
+            if (used == STREAM_BLOCK_DIGITS) {
+                parts.emplace_back();
+                from_decimal_basecase(block, used, parts.back());
+                levels.push_back(0);
+                used = 0;
+                while (levels.size() > 1 &&
+                       levels.back() == levels[levels.size() - 2]) {
+                    combine(parts[parts.size() - 2], parts.back(),
+                            levels.back());
+                    parts.pop_back();
+                    levels.pop_back();
+                    ++levels.back();
+                }
+            }
+        }
+
+        void finish(DigitVector& result) {
+            DigitVector tail;
+            from_decimal_basecase(block, used, tail);
+            if (parts.empty()) {
+                result = std::move(tail);
+                return;
+            }
+            // the parts shrink from the most significant on
+            for (size_t i = 1; i < parts.size(); ++i) {
+                combine(parts[0], parts[i], levels[i]);
+            }
+            DigitVector scale, t;
+            power(DigitVector(1, 10), unsigned(used), scale);
+            multiply(parts[0], scale, t);
+            result.clear();
+            add(t, tail, result);
+        }
+
+    private:
+        char block[STREAM_BLOCK_DIGITS];
+        size_t used = 0;
+        // parts[i] holds STREAM_BLOCK_DIGITS << levels[i] digits
+        std::vector<DigitVector> parts;
+        std::vector<size_t> levels;
+        // DEC_CHUNK^(2^k), i.e. 10^(STREAM_BLOCK_DIGITS << level) at
+        // k = level + log2(STREAM_BLOCK_CHUNKS)
+        std::vector<DigitVector> powers;
+
+        // high = high * 10^(length of low) + low
+        void combine(DigitVector& high, const DigitVector& low,
+                     const size_t level) {
+            const size_t k = level + size_t(__builtin_ctzll(
+                                 STREAM_BLOCK_CHUNKS));
+            if (powers.empty()) {
+                powers = decimal_powers(k + 1);
+            }
+            while (powers.size() <= k) {
+                DigitVector sq;
+                multiply(powers.back(), powers.back(), sq);
+                powers.push_back(std::move(sq));
+            }
+            DigitVector t;
+            multiply(high, powers[k], t);
+            high.clear();
+            add(t, low, high);
+        }
+};
+
+// Hexadecimal and octal digits are packed into groups of 16 or 21 (64 or
+// 63 bits) as they are read, and the groups placed at their final bit
+// offsets once the number of digits is known.
+class PowerOfTwoBaseReader {
+    public:
+        explicit PowerOfTwoBaseReader(const unsigned bits_in)
+            : bits(bits_in), per_group(64 / bits_in) { }
+
+        void push(const int v) {
+            group = (group << bits) | uint64_t(v);
+            if (++used == per_group) {
+                groups.push_back(group);
+                group = 0;
+                used = 0;
+            }
+        }
+
+        void finish(DigitVector& result) {
+            const size_t group_bits = per_group * bits;
+            const size_t total = groups.size() * group_bits + used * bits;
+            result.assign(total / 64 + 1, 0);
+            place(result, group, 0);
+            for (size_t i = 0; i < groups.size(); ++i) {
+                place(result, groups[i], total - (i + 1) * group_bits);
+            }
+            rem_lzeros(result);
+        }
+
+    private:
+        const unsigned bits;
+        const size_t per_group;
+        std::vector<uint64_t> groups; // most significant first
+        uint64_t group = 0;
+        size_t used = 0;
+
+        static void place(DigitVector& r, const uint64_t v,
+                          const size_t pos) {
+            const unsigned shift = unsigned(pos % 64);
+            r[pos / 64] |= v << shift;
+            if (shift > 0 && pos / 64 + 1 < r.size()) {
+                r[pos / 64 + 1] |= v >> (64 - shift);
+            }
+        }
+};
+
+// ^^^^^ stream input ^^^^^
+
+// vvvvv native fast paths vvvvv
+//
+// When both operands fit in the inline digits of a DigitVector, the
+// arithmetic operators skip the general routines and work on native
+// 128-bit integers.
+
+static bool fits_128(const DigitVector& a) {
+    return a.size() <= 2;
+}
+
+static uint128_t to_128(const DigitVector& a) {
+    return a.size() == 1 ? a[0] : (uint128_t(a[1]) << 64) | a[0];
+}
+
+// result = (-1)^a_neg a + (-1)^b_neg b, if both fit in 128 bits;
+// otherwise returns false without touching the outputs
+static bool add_small(const DigitVector& a, const bool a_neg,
+                      const DigitVector& b, const bool b_neg,
+                      DigitVector& result, bool& result_neg) {
+    if (!fits_128(a) || !fits_128(b)) {
+        return false;
+    }
+    const uint128_t x = to_128(a);
+    const uint128_t y = to_128(b);
+    uint128_t r;
+    uint64_t carry = 0;
+    if (a_neg == b_neg) {
+        r = x + y;
+        carry = r < x ? 1 : 0;
+        result_neg = a_neg;
+    }
+    else if (x >= y) {
+        r = x - y;
+        result_neg = a_neg;
+    }
+    else {
+        r = y - x;
+        result_neg = b_neg;
+    }
+    result.assign(1, uint64_t(r));
+    result.push_back(uint64_t(r >> 64));
+    if (carry) {
+        result.push_back(carry);
+    }
+    rem_lzeros(result);
+    return true;
+}
+
+// result = a * b, if both are single digits; otherwise returns false
+static bool multiply_small(const DigitVector& a, const DigitVector& b,
+                           DigitVector& result) {
+    if (a.size() != 1 || b.size() != 1) {
+        return false;
+    }
+    STATS_ALGORITHM(MUL_NATIVE);
+    const uint128_t p = uint128_t(a[0]) * b[0];
+    result.assign(1, uint64_t(p));
+    result.push_back(uint64_t(p >> 64));
+    rem_lzeros(result);
+    return true;
+}
+
+// ^^^^^ native fast paths ^^^^^
+
+// vvvvv signed addition vvvvv
+//
+// The sign-magnitude cases of addition and subtraction, shared by the
+// binary and compound operators; a - b is a + (-b). The in-place forms
+// reuse the left operand's buffer, so accumulating into a BigInt only
+// allocates when it outgrows its capacity.
+
+static bool is_zero(const DigitVector& a) {
+    return a.size() == 1 && a[0] == 0;
+}
+
+// in-place a += b for nonnegative a and b; b may be a itself
+static void add_in_place(DigitVector& a, const DigitVector& b) {
+    const size_t bn = b.size();
+    if (a.size() < bn) {
+        a.resize(bn, 0);
+    }
+    uint64_t carry = add_into(a.data(), a.size(), b.data(), bn);
+    if (carry) {
+        a.push_back(carry);
+    }
+}
+
+// in-place a -= b for nonnegative a >= b; b may be a itself
+static void sub_in_place(DigitVector& a, const DigitVector& b) {
+    const size_t bn = b.size();
+    uint64_t borrow = sub_n(a.data(), a.data(), b.data(), bn);
+    borrow = sub_1(a.data() + bn, a.data() + bn, a.size() - bn, borrow);
+    assert(borrow == 0);
+    (void)borrow;
+    rem_lzeros(a);
+}
+
+// in-place a = b - a for nonnegative a < b
+static void rsub_in_place(DigitVector& a, const DigitVector& b) {
+    assert(&a != &b);
+    a.resize(b.size(), 0);
+    uint64_t borrow = sub_n(a.data(), b.data(), a.data(), b.size());
+    assert(borrow == 0);
+    (void)borrow;
+    rem_lzeros(a);
+}
+
+// result = (-1)^a_neg a + (-1)^b_neg b, where result is neither a nor b
+static void add_signed(const DigitVector& a, const bool a_neg,
+                       const DigitVector& b, const bool b_neg,
+                       DigitVector& result, bool& result_neg) {
+    if (!add_small(a, a_neg, b, b_neg, result, result_neg)) {
+        result.clear();
+        if (a_neg == b_neg) {
+            add(a, b, result);
+            result_neg = a_neg;
+        }
+        else if (compare(a, b) >= 0) {
+            subtract(a, b, result);
+            result_neg = a_neg;
+        }
+        else {
+            subtract(b, a, result);
+            result_neg = b_neg;
+        }
+    }
+    if (is_zero(result)) {
+        result_neg = false;
+    }
+}
+
+// a = (-1)^a_neg a + (-1)^b_neg b, in place; b may be a itself
+static void add_signed_in_place(DigitVector& a, bool& a_neg,
+                                const DigitVector& b, const bool b_neg) {
+    if (!add_small(a, a_neg, b, b_neg, a, a_neg)) {
+        if (a_neg == b_neg) {
+            add_in_place(a, b);
+        }
+        else if (compare(a, b) >= 0) {
+            sub_in_place(a, b);
+        }
+        else {
+            rsub_in_place(a, b);
+            a_neg = b_neg;
+        }
+    }
+    if (is_zero(a)) {
+        a_neg = false;
+    }
+}
+
+// in-place a = b^n - a for n = a.size(), turning a negative n-digit two's
+// complement number into its magnitude
+static void negate_twos_complement(DigitVector& a) {
+    uint64_t c = 1;
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint128_t t = uint128_t(~a[i]) + c;
+        a[i] = uint64_t(t);
+        c = uint64_t(t >> 64);
+    }
+}
+
+// ^^^^^ signed addition ^^^^^
+
+// vvvvv Montgomery arithmetic vvvvv
+//
+// For an odd k-digit modulus n and R = b^k, REDC(t) = t R^-1 mod n for
+// t < n R: adding m n to t, with m chosen digit by digit so that the low
+// digit becomes zero, makes t divisible by R, and the quotient is below
+// 2n. The product of two values in Montgomery form, x R and y R, reduces
+// to x y R, so a whole exponentiation works on that form, with only one
+// conversion at each end.
+
+// r[0..k) = t[0..2k) R^-1 mod n, where t < n R and n_inv = -n^-1 mod b.
+// t is overwritten; r may be any k digits, including part of t.
+static void mont_reduce(uint64_t* r, uint64_t* t, const uint64_t* n,
+                        const size_t k, const uint64_t n_inv) {
+    uint64_t top = 0; // the digit above t[2k), 0 or 1
+    for (size_t i = 0; i < k; ++i) {
+        // t[i] + m n[0] is zero modulo b
+        const uint64_t m = t[i] * n_inv;
+        const uint128_t s = uint128_t(t[i + k]) + addmul_1(t + i, n, k, m)
+                            + top;
+        t[i + k] = uint64_t(s);
+        top = uint64_t(s >> 64);
+    }
+    // t[k..2k) + top R is below 2n; the borrow of the subtraction
+    // cancels top
+    if (top || cmp_n(t + k, n, k) >= 0) {
+        sub_n(r, t + k, n, k);
+    }
+    else {
+        std::copy(t + k, t + 2 * k, r);
+    }
+}
+
+// r[0..k) = a b R^-1 mod n for a, b < n, using t[0..2k) as scratch; r may
+// be a or b
+static void mont_mul(uint64_t* r, const uint64_t* a, const uint64_t* b,
+                     const uint64_t* n, const size_t k, const uint64_t n_inv,
+                     uint64_t* t) {
+    mul_n_m(t, a, k, b, k);
+    mont_reduce(r, t, n, k, n_inv);
+}
+
+// the sliding window width, in bits, for an exponent of the given length.
+// A width of w costs 2^(w-1) multiplications up front to save about
+// bits / (w + 1) later, so it grows with the exponent.
+static unsigned window_bits(const size_t exp_bits) {
+    static const size_t limits[] = {7, 25, 81, 241, 673, 1793};
+    unsigned w = 1;
+    for (size_t limit : limits) {
+        if (exp_bits > limit) {
+            ++w;
+        }
+    }
+    return w;
+}
+
+static bool test_bit(const DigitVector& a, const size_t i) {
+    return (a[i / 64] >> (i % 64)) & 1;
+}
+
+// ^^^^^ Montgomery arithmetic ^^^^^
+
+// vvvvv short products vvvvv
+//
+// Barrett reduction only needs the top half of one product and the bottom
+// half of another. Leaving out the partial products that can't matter
+// halves the schoolbook work, which keeps it ahead of a full Karatsuba
+// product up to about SHORT_PRODUCT_THRESHOLD digits; beyond that these
+// fall back to mul_n_m.
+
+static const size_t SHORT_PRODUCT_THRESHOLD = 100;
+
+// r[0..an+bn) = a * b less an error below b^(lo+1), for lo >= 1: the
+// partial products a[i] b[j] with i + j < lo - 1 are left out
+static void mul_high(uint64_t* r, const uint64_t* a, const size_t an,
+                     const uint64_t* b, const size_t bn, const size_t lo) {
+    assert(lo >= 1);
+    if (std::min(an, bn) >= SHORT_PRODUCT_THRESHOLD) {
+        mul_n_m(r, a, an, b, bn);
+        return;
+    }
+    std::fill(r, r + an + bn, uint64_t(0));
+    for (size_t j = 0; j < bn; ++j) {
+        const size_t i0 = lo - 1 > j ? lo - 1 - j : 0;
+        if (i0 < an) {
+            r[an + j] = addmul_1(r + i0 + j, a + i0, an - i0, b[j]);
+        }
+    }
+}
+
+// r[0..n) = a * b mod b^n, where n <= an + bn
+static void mul_low(uint64_t* r, const uint64_t* a, const size_t an,
+                    const uint64_t* b, const size_t bn, const size_t n) {
+    if (std::min(an, bn) >= SHORT_PRODUCT_THRESHOLD) {
+        DigitVector full(an + bn);
+        mul_n_m(full.data(), a, an, b, bn);
+        std::copy(full.begin(), full.begin() + n, r);
+        return;
+    }
+    std::fill(r, r + n, uint64_t(0));
+    for (size_t j = 0; j < std::min(bn, n); ++j) {
+        const size_t len = std::min(an, n - j);
+        const uint64_t carry = addmul_1(r + j, a, len, b[j]);
+        if (j + len < n) {
+            r[j + len] = carry;
+        }
+    }
+}
+
+// ^^^^^ short products ^^^^^
+
+// vvvvv greatest common divisors vvvvv
+//
+// Each algorithm below reduces a pair (c, d) of nonnegative integers by
+// steps that subtract a multiple of one from the other, which leave their
+// gcd unchanged, until one of them is zero. The steps taken so far make up
+// a matrix M of nonnegative integers with determinant 1 such that
+//      (c0, d0) = M (c, d)
+// for the starting pair, from whose inverse extended_gcd reads off the
+// cofactors at the end.
+//
+// Lehmer's algorithm (Knuth, Algorithm 4.5.2L) runs the Euclidean
+// algorithm in single precision on the top 64 bits of c and d, for as
+// long as its quotients are sure to be the true ones, and then applies
+// the resulting single-digit matrix to the whole numbers in one pass, so
+// that each pass takes off about 32 bits. The half-gcd (Schönhage; see
+// Möller, "On Schönhage's algorithm and subquadratic integer gcd
+// computation", 2008) finds the matrix that takes a pair about halfway
+// down from just the top half of its bits, recursively, and applies it by
+// fast multiplication, for O(M(n) log n) in all.
+//
+// A matrix found from the top bits of c and d is only applied if the
+// whole numbers come out nonnegative (which is all the gcd needs), and
+// otherwise a plain division step is taken instead.
+
+// [m00 m01; m10 m11], with nonnegative entries and determinant 1
+struct GcdMatrix {
+    DigitVector m00 = {1};
+    DigitVector m01 = {0};
+    DigitVector m10 = {0};
+    DigitVector m11 = {1};
+};
+
+// Below this many digits in the smaller number, Lehmer steps are used
+// rather than the half-gcd (measured as for the multiplication thresholds)
+static const size_t HGCD_THRESHOLD = 150;
+
+// a x + b y
+static DigitVector mul_add_1(const DigitVector& a, const uint64_t x,
+                             const DigitVector& b, const uint64_t y) {
+    const size_t n = std::max(a.size(), b.size()) + 2;
+    DigitVector r(n, 0);
+    r[a.size()] = addmul_1(r.data(), a.data(), a.size(), x);
+    const uint64_t carry = addmul_1(r.data(), b.data(), b.size(), y);
+    add_1(r.data() + b.size(), r.data() + b.size(), n - b.size(), carry);
+    rem_lzeros(r);
+    return r;
+}
+
+// a x + b y
+static DigitVector mul_add(const DigitVector& a, const DigitVector& x,
+                           const DigitVector& b, const DigitVector& y) {
+    DigitVector ax, by, r;
+    multiply(a, x, ax);
+    multiply(b, y, by);
+    add(ax, by, r);
+    return r;
+}
+
+// M K for a single-digit K = [k0 k1; k2 k3]
+static GcdMatrix gcd_matrix_mul_1(const GcdMatrix& M, const uint64_t k[4]) {
+    GcdMatrix r;
+    r.m00 = mul_add_1(M.m00, k[0], M.m01, k[2]);
+    r.m01 = mul_add_1(M.m00, k[1], M.m01, k[3]);
+    r.m10 = mul_add_1(M.m10, k[0], M.m11, k[2]);
+    r.m11 = mul_add_1(M.m10, k[1], M.m11, k[3]);
+    return r;
+}
+
+static GcdMatrix gcd_matrix_mul(const GcdMatrix& A, const GcdMatrix& B) {
+    GcdMatrix r;
+    r.m00 = mul_add(A.m00, B.m00, A.m01, B.m10);
+    r.m01 = mul_add(A.m00, B.m01, A.m01, B.m11);
+    r.m10 = mul_add(A.m10, B.m00, A.m11, B.m10);
+    r.m11 = mul_add(A.m10, B.m01, A.m11, B.m11);
+    return r;
+}
+
+static bool is_identity(const GcdMatrix& M) {
+    return is_zero(M.m01) && is_zero(M.m10);
+}
+
+// whether min(c, d) exceeds every entry of M. Then M is also the matrix
+// of steps for any pair that c and d are the top bits of: with
+// c0 = 2^p c0' + e and d0 = 2^p d0' + f for e, f < 2^p and
+// (c0', d0') = M (c, d), the whole numbers reduce to
+//      M^-1 (c0, d0) = 2^p (c, d) + M^-1 (e, f),
+// and each entry of M^-1 (e, f) is a difference of two products that
+// are both below 2^p min(c, d), so neither comes out negative.
+static bool gcd_reduced(const DigitVector& c, const DigitVector& d,
+                        const GcdMatrix& M) {
+    const DigitVector& low = compare(c, d) < 0 ? c : d;
+    return compare(low, M.m00) > 0 && compare(low, M.m01) > 0
+        && compare(low, M.m10) > 0 && compare(low, M.m11) > 0;
+}
+
+// in-place (c, d) = M^-1 (c, d) = (m11 c - m01 d, m00 d - m10 c); false,
+// leaving c and d as they were, if either would be negative
+static bool gcd_apply_inverse(DigitVector& c, DigitVector& d,
+                              const GcdMatrix& M) {
+    DigitVector c_pos, c_neg, d_pos, d_neg;
+    multiply(M.m11, c, c_pos);
+    multiply(M.m01, d, c_neg);
+    multiply(M.m00, d, d_pos);
+    multiply(M.m10, c, d_neg);
+    if (compare(c_pos, c_neg) < 0 || compare(d_pos, d_neg) < 0) {
+        return false;
+    }
+    c.clear();
+    subtract(c_pos, c_neg, c);
+    d.clear();
+    subtract(d_pos, d_neg, d);
+    return true;
+}
+
+// one step of the Euclidean algorithm on nonzero c and d: the larger
+// becomes its remainder modulo the smaller, and M (if given) follows
+static void gcd_div_step(DigitVector& c, DigitVector& d, GcdMatrix* M) {
+    DigitVector q, r, t;
+    if (compare(c, d) >= 0) {
+        // (c, d) = [1 q; 0 1] (r, d)
+        divide(c, d, q, r);
+        c = std::move(r);
+        if (M) {
+            M->m01 = mul_add(M->m01, DigitVector{1}, M->m00, q);
+            M->m11 = mul_add(M->m11, DigitVector{1}, M->m10, q);
+        }
+    }
+    else {
+        // (c, d) = [1 0; q 1] (c, r)
+        divide(d, c, q, r);
+        d = std::move(r);
+        if (M) {
+            M->m00 = mul_add(M->m00, DigitVector{1}, M->m01, q);
+            M->m10 = mul_add(M->m10, DigitVector{1}, M->m11, q);
+        }
+    }
+}
+
+// the 64 bits of a from bit shift up
+static uint64_t bits_at(const DigitVector& a, const size_t shift) {
+    const size_t i = shift / 64;
+    const unsigned s = unsigned(shift % 64);
+    if (i >= a.size()) {
+        return 0;
+    }
+    uint64_t bits = a[i] >> s;
+    if (s && i + 1 < a.size()) {
+        bits |= a[i + 1] << (64 - s);
+    }
+    return bits;
+}
+
+// the matrix K = [k0 k1; k2 k3] of the Euclidean steps on single digits x
+// and y that leave both at least 2^32. Since K's entries are then below
+// 2^32 as well, K is valid for any numbers that x and y are the top 64
+// bits of (see gcd_reduced). False if there are no such steps.
+static bool lehmer_matrix(uint64_t x, uint64_t y, uint64_t k[4]) {
+    const uint64_t limit = uint64_t(1) << 32;
+    k[0] = 1;
+    k[1] = 0;
+    k[2] = 0;
+    k[3] = 1;
+    bool stepped = false;
+    while (true) {
+        if (x >= y) {
+            if (y < limit || x - x / y * y < limit) {
+                break;
+            }
+            const uint64_t q = x / y;
+            x -= q * y;
+            k[1] += q * k[0];
+            k[3] += q * k[2];
+        }
+        else {
+            if (x < limit || y - y / x * x < limit) {
+                break;
+            }
+            const uint64_t q = y / x;
+            y -= q * x;
+            k[0] += q * k[1];
+            k[2] += q * k[3];
+        }
+        stepped = true;
+    }
+    return stepped;
+}
+
+// r[0..n] = a[0..n) x - b[0..n) y; false if that is negative
+static bool mul_sub_1(uint64_t* r, const uint64_t* a, const uint64_t x,
+                      const uint64_t* b, const uint64_t y, const size_t n) {
+    std::fill(r, r + n, uint64_t(0));
+    r[n] = addmul_1(r, a, n, x);
+    const uint64_t borrow = submul_1(r, b, n, y);
+    if (r[n] < borrow) {
+        return false;
+    }
+    r[n] -= borrow;
+    return true;
+}
+
+// one Lehmer step on nonzero c and d, with M (if given) following; false,
+// leaving everything as it was, if the top bits gave no usable matrix or,
+// when keep_reduced is set, if the step would leave c and d unreduced for M
+static bool gcd_lehmer_step(DigitVector& c, DigitVector& d, GcdMatrix* M,
+                            const bool keep_reduced = false) {
+    const size_t bits = std::max(bit_length(c), bit_length(d));
+    const size_t shift = bits > 64 ? bits - 64 : 0;
+    uint64_t k[4];
+    if (!lehmer_matrix(bits_at(c, shift), bits_at(d, shift), k)) {
+        return false;
+    }
+    // (c, d) = K^-1 (c, d) = (k3 c - k1 d, k0 d - k2 c)
+    const size_t n = std::max(c.size(), d.size());
+    DigitVector a = c, b = d, c2(n + 1), d2(n + 1);
+    a.resize(n, 0);
+    b.resize(n, 0);
+    if (!mul_sub_1(c2.data(), a.data(), k[3], b.data(), k[1], n) ||
+        !mul_sub_1(d2.data(), b.data(), k[0], a.data(), k[2], n)) {
+        return false;
+    }
+    rem_lzeros(c2);
+    rem_lzeros(d2);
+    if (M) {
+        GcdMatrix M2 = gcd_matrix_mul_1(*M, k);
+        if (keep_reduced && !gcd_reduced(c2, d2, M2)) {
+            return false;
+        }
+        *M = std::move(M2);
+    }
+    c = std::move(c2);
+    d = std::move(d2);
+    return true;
+}
+
+// the half-gcd's base case: Lehmer or division steps on c and d, for as
+// long as they stay reduced for the matrix M of all the steps
+static void hgcd_base(DigitVector& c, DigitVector& d, GcdMatrix& M) {
+    while (!is_zero(c) && !is_zero(d)) {
+        if (gcd_lehmer_step(c, d, &M, true)) {
+            continue;
+        }
+        DigitVector c2 = c, d2 = d;
+        GcdMatrix M2 = M;
+        gcd_div_step(c2, d2, &M2);
+        if (!gcd_reduced(c2, d2, M2)) {
+            break;
+        }
+        c = std::move(c2);
+        d = std::move(d2);
+        M = std::move(M2);
+    }
+}
+
+// bits kept between the entries of the half-gcd's matrix and the numbers
+// it reduces, so that the second recursive matrix rarely overshoots
+static const size_t HGCD_MARGIN = 64;
+
+// Reduces nonzero c and d, of at most n bits, by steps whose matrix M is
+// returned, to a pair that is reduced for M (see gcd_reduced). M's
+// entries grow to about n / 2 bits, and c and d shrink to a little more.
+// The top half of the bits gives the first quarter of the way by
+// recursion, a division step follows, and then the top of what remains
+// gives the second quarter.
+static GcdMatrix hgcd(DigitVector& c, DigitVector& d) {
+    GcdMatrix M;
+    if (std::min(c.size(), d.size()) < HGCD_THRESHOLD) {
+        hgcd_base(c, d, M);
+        return M;
+    }
+    const size_t n = std::max(bit_length(c), bit_length(d));
+
+    // try applying the matrix of the top bits [p, n) to c and d, keeping
+    // it if they stay reduced
+    auto reduce_by_top = [&](const size_t p) {
+        DigitVector c_top, d_top;
+        shift_right(c, p, c_top);
+        shift_right(d, p, d_top);
+        if (is_zero(c_top) || is_zero(d_top)) {
+            return;
+        }
+        GcdMatrix top = hgcd(c_top, d_top);
+        if (is_identity(top)) {
+            return;
+        }
+        DigitVector c2 = c, d2 = d;
+        GcdMatrix M2 = gcd_matrix_mul(M, top);
+        if (gcd_apply_inverse(c2, d2, top) && gcd_reduced(c2, d2, M2)) {
+            c = std::move(c2);
+            d = std::move(d2);
+            M = std::move(M2);
+        }
+    };
+
+    reduce_by_top(n / 2);
+
+    if (!is_zero(c) && !is_zero(d)) {
+        DigitVector c2 = c, d2 = d;
+        GcdMatrix M2 = M;
+        gcd_div_step(c2, d2, &M2);
+        if (!gcd_reduced(c2, d2, M2)) {
+            return M;
+        }
+        c = std::move(c2);
+        d = std::move(d2);
+        M = std::move(M2);
+    }
+
+    // a pair of m bits gives a matrix of about m / 2 bits, which should
+    // bring M's entries up to n / 2 bits less the margin
+    const size_t entries = std::max({bit_length(M.m00), bit_length(M.m01),
+                                     bit_length(M.m10), bit_length(M.m11)});
+    if (!is_zero(c) && !is_zero(d) && entries + HGCD_MARGIN < n / 2) {
+        const size_t m = 2 * (n / 2 - HGCD_MARGIN - entries);
+        const size_t cd = std::max(bit_length(c), bit_length(d));
+        if (cd > m) {
+            reduce_by_top(cd - m);
+        }
+    }
+    return M;
+}
+
+// reduces c and d to (g, 0) or (0, g) for their gcd g, with M (if given)
+// following
+static void gcd_reduce(DigitVector& c, DigitVector& d, GcdMatrix* M) {
+    while (!is_zero(c) && !is_zero(d)) {
+        const size_t cb = bit_length(c);
+        const size_t db = bit_length(d);
+        if (std::max(cb, db) - std::min(cb, db) >= 64) {
+            // too far apart for the top bits to give more than one quotient
+            gcd_div_step(c, d, M);
+        }
+        else if (std::min(c.size(), d.size()) >= HGCD_THRESHOLD) {
+            GcdMatrix H = hgcd(c, d);
+            if (is_identity(H)) {
+                gcd_div_step(c, d, M);
+            }
+            else if (M) {
+                *M = gcd_matrix_mul(*M, H);
+            }
+        }
+        else if (!gcd_lehmer_step(c, d, M)) {
+            gcd_div_step(c, d, M);
+        }
+    }
+}
+
+// ^^^^^ greatest common divisors ^^^^^
+
+// vvvvv integer roots vvvvv
+
+// the low bits of a, as a normalized number
+static void low_bits(const DigitVector& a, const size_t bits,
+                     DigitVector& result) {
+    const size_t n = std::min(a.size(), (bits + 63) / 64);
+    result.assign(a.begin(), a.begin() + n);
+    if (n * 64 > bits) {
+        result.back() &= (uint64_t(1) << (bits % 64)) - 1;
+    }
+    rem_lzeros(result);
+}
+
+// s = floor(sqrt(n)) and r = n - s^2 for nonnegative n, by Zimmermann's
+// recursive square root ("Karatsuba Square Root", 1999). Split n into four
+// b-bit pieces, n = a3 B^3 + a2 B^2 + a1 B + a0 with B = 2^b and a3 at
+// least B / 4. From the root s' and remainder r' of the top half,
+//      (q, u) = divmod(r' B + a1, 2 s'),
+//      s = s' B + q,  r = u B + a0 - q^2,
+// and if r is negative, s is one too large. Apart from the recursion that
+// is a division of half n's length by a quarter of it and a square of a
+// quarter, so the whole costs a small multiple of one full-size product.
+static void sqrt_rem(const DigitVector& n, DigitVector& s, DigitVector& r) {
+    if (fits_128(n)) {
+        // the double's root is within a relative 2^-52 of the true one, so
+        // a Newton step lands on the root or one above (AM-GM again)
+        const uint128_t v = to_128(n);
+        uint128_t x = uint128_t(std::sqrt(double(v)));
+        if (x > 0) {
+            x = std::min((x + v / x) / 2, uint128_t(~uint64_t(0)));
+            if (x * x > v) {
+                --x;
+            }
+        }
+        const uint128_t rem = v - x * x;
+        s.assign(1, uint64_t(x));
+        r.assign(1, uint64_t(rem));
+        r.push_back(uint64_t(rem >> 64));
+        rem_lzeros(r);
+        return;
+    }
+    const size_t bits = bit_length(n);
+    const size_t b = (bits + 3) / 4;
+    if (4 * b - bits >= 2) {
+        // a3 < B / 4, so take the root of 4n = (2s + s0)^2 + r, with s0
+        // its low bit; then n = s^2 + s s0 + (r + s0) / 4
+        DigitVector m;
+        shift_left(n, 2, m);
+        sqrt_rem(m, s, r);
+        const uint64_t s0 = s[0] & 1;
+        rshift_in_place(s.data(), s.size(), 1);
+        rem_lzeros(s);
+        mul_add_single_precision(r, 1, s0);
+        rshift_in_place(r.data(), r.size(), 2);
+        rem_lzeros(r);
+        if (s0) {
+            add_in_place(r, s);
+        }
+        return;
+    }
+
+    DigitVector top, t, a, d, q, u;
+    shift_right(n, 2 * b, top);
+    sqrt_rem(top, s, r);
+    shift_left(r, b, t);
+    shift_right(n, b, a);
+    low_bits(a, b, u);
+    add_in_place(t, u);
+    shift_left(s, 1, d);
+    divide(t, d, q, u);
+
+    shift_left(s, b, t);
+    add_in_place(t, q);
+    s = std::move(t);
+    shift_left(u, b, r);
+    low_bits(n, b, a);
+    add_in_place(r, a);
+    multiply(q, q, t);
+    if (compare(r, t) < 0) {
+        // (s - 1)^2 = s^2 - 2s + 1, so the remainder gains 2s - 1
+        add_in_place(r, s);
+        add_in_place(r, s);
+        sub_in_place(r, DigitVector(1, 1));
+        sub_in_place(s, DigitVector(1, 1));
+    }
+    sub_in_place(r, t);
+}
+
+// the Newton step for the k-th root from x, floor(((k - 1) x + n / x^(k-1))
+// / k), which is at least floor(n^(1/k)) for any positive x by the AM-GM
+// inequality
+static void root_step(const DigitVector& n, const unsigned k,
+                      const DigitVector& x, DigitVector& y) {
+    DigitVector p, r;
+    power(x, k - 1, p);
+    divide(n, p, y, r);
+    DigitVector t = x;
+    mul_add_single_precision(t, k - 1, 0);
+    add_in_place(y, t);
+    divide_single_precision(y, k);
+}
+
+// s = floor(n^(1/k)) for nonnegative n and k >= 2, doubling the precision
+// on the way out of the recursion. With L the bit length of n, the root s'
+// of floor(n / 2^kh) gives x = (s' + 1) 2^h, above the root r by at most
+// 2^h. A Newton step for x^k - n from there lands at most 2^2h (k - 1) / 2x
+// above r, which is below one when 2^2h k <= 2^((L - 1) / k) <= r, and
+// never below floor(r), so at most one correction is left. The work is
+// dominated by the step at full size, a power and a division. Roots of up
+// to 32 bits (or a few more than k has, for which h would reach zero) are
+// rounded from a floating-point estimate instead.
+static void root(const DigitVector& n, const unsigned k, DigitVector& s) {
+    if (k == 2) {
+        DigitVector r;
+        sqrt_rem(n, s, r);
+        return;
+    }
+    const size_t bits = bit_length(n);
+    if (bits <= k) {
+        // n < 2^k, so the root is 0 or 1
+        s.assign(1, bits == 0 ? 0 : 1);
+        return;
+    }
+    unsigned k_bits = 0;
+    while (k >> k_bits) {
+        ++k_bits;
+    }
+    const size_t root_bits = (bits - 1) / k;
+    if (root_bits < std::max(size_t(32), size_t(k_bits + 2))) {
+        // log2(n) from its top 64 bits, good to about 2^-52 relative to
+        // log2(n) / k < 34 after the division, so the rounded estimate of a
+        // root below 2^34 is at most one off
+        const size_t shift = bits > 64 ? bits - 64 : 0;
+        DigitVector top, p;
+        shift_right(n, shift, top);
+        const double lg = std::log2(double(top[0])) + double(shift);
+        uint64_t x = uint64_t(std::llround(std::exp2(lg / k)));
+        auto above = [&](const uint64_t y) {
+            power(DigitVector(1, y), k, p);
+            return compare(p, n) > 0;
+        };
+        while (x > 0 && above(x)) {
+            --x;
+        }
+        while (!above(x + 1)) {
+            ++x;
+        }
+        s.assign(1, x);
+        return;
+    }
+    const size_t h = (root_bits - k_bits) / 2;
+    DigitVector top, x;
+    shift_right(n, k * h, top);
+    root(top, k, s);
+    mul_add_single_precision(s, 1, 1);
+    shift_left(s, h, x);
+    root_step(n, k, x, s);
+
+    DigitVector p;
+    power(s, k, p);
+    if (compare(p, n) > 0) {
+        sub_in_place(s, DigitVector(1, 1));
+    }
+}
+
+// ^^^^^ integer roots ^^^^^
+
+// vvvvv binary format vvvvv
+//
+// See BigInt::serialize for the layout. On a little-endian host the digits
+// are copied (or viewed) as they are; otherwise each is assembled from its
+// bytes.
+
+static const size_t SERIAL_HEADER_BYTES = 16;
+
+static uint64_t load_le64(const unsigned char* p) {
+    uint64_t x = 0;
+    for (int i = 7; i >= 0; --i) {
+        x = (x << 8) | p[i];
+    }
+    return x;
+}
+
+static void store_le64(unsigned char* p, uint64_t x) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = (unsigned char)(x >> (8 * i));
+    }
+}
+
+// the sign and digit count of the record at the start of [data, data +
+// size), after checking that it is all there and well formed: a known
+// version, reserved bytes zero, and a normalized value (at least one
+// digit, no leading zero digits, no negative zero)
+static void read_header(const unsigned char* data, const size_t size,
+                        bool& negative, size_t& count) {
+    if (size < SERIAL_HEADER_BYTES) {
+        throw std::invalid_argument("BigInt binary record is truncated.");
+    }
+    if (data[0] != BigInt::SERIAL_VERSION) {
+        throw std::invalid_argument("BigInt binary record has an unknown "
+                                    "version.");
+    }
+    bool ok = data[1] <= 1;
+    for (size_t i = 2; i < 8; ++i) {
+        ok = ok && data[i] == 0;
+    }
+    const uint64_t c = load_le64(data + 8);
+    if (c > (size - SERIAL_HEADER_BYTES) / 8) {
+        throw std::invalid_argument("BigInt binary record is truncated.");
+    }
+    if (ok && c > 0) {
+        const unsigned char* last = data + SERIAL_HEADER_BYTES + 8 * (c - 1);
+        const uint64_t top = load_le64(last);
+        ok = top != 0 || (c == 1 && data[1] == 0);
+    }
+    if (!ok || c == 0) {
+        throw std::invalid_argument("BigInt binary record is malformed.");
+    }
+    negative = data[1] == 1;
+    count = size_t(c);
+}
+
+// r = (-1)^a_neg a[0..an) + (-1)^b_neg b[0..bn), for normalized a and b.
+// r may be a or b only if it has room for max(an, bn) + 1 digits, so that
+// resizing it doesn't move them.
+static void add_signed_n(const uint64_t* a, const size_t an, const bool a_neg,
+                         const uint64_t* b, const size_t bn, const bool b_neg,
+                         DigitVector& r, bool& r_neg) {
+    if (an < bn) {
+        add_signed_n(b, bn, b_neg, a, an, a_neg, r, r_neg);
+        return;
+    }
+    if (a_neg == b_neg) {
+        r.resize(an + 1);
+        r[an] = add_1(r.data() + bn, a + bn, an - bn,
+                      add_n(r.data(), a, b, bn));
+        r_neg = a_neg;
+    }
+    else if (an > bn || cmp_n(a, b, an) >= 0) {
+        r.resize(an);
+        uint64_t borrow = sub_1(r.data() + bn, a + bn, an - bn,
+                                sub_n(r.data(), a, b, bn));
+        assert(borrow == 0);
+        (void)borrow;
+        r_neg = a_neg;
+    }
+    else {
+        r.resize(an);
+        sub_n(r.data(), b, a, an);
+        r_neg = b_neg;
+    }
+    rem_lzeros(r);
+    r_neg = r_neg && !is_zero(r);
+}
+
+// ^^^^^ binary format ^^^^^
+
+// vvvvv bulk loading vvvvv
+
+// the contents of a file, memory-mapped where the platform allows and
+// otherwise read into memory
+class FileContents {
+    public:
+        explicit FileContents(const std::string& path) {
+#ifdef BIGINT_MMAP
+            const int fd = open(path.c_str(), O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                fail(path);
+            }
+            size = size_t(st.st_size);
+            void* p = size > 0
+                ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                : nullptr;
+            close(fd);
+            if (p == MAP_FAILED) {
+                fail(path);
+            }
+            if (p) {
+                madvise(p, size, MADV_SEQUENTIAL);
+            }
+            data = static_cast<const char*>(p);
+#else
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                fail(path);
+            }
+            buffer.assign(std::istreambuf_iterator<char>(in),
+                          std::istreambuf_iterator<char>());
+            data = buffer.data();
+            size = buffer.size();
+#endif
+        }
+
+        ~FileContents() {
+#ifdef BIGINT_MMAP
+            if (data) {
+                munmap(const_cast<char*>(data), size);
+            }
+#endif
+        }
+
+        FileContents(const FileContents&) = delete;
+        FileContents& operator=(const FileContents&) = delete;
+
+        const char* begin() const { return data; }
+        const char* end() const { return data + size; }
+
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+#ifndef BIGINT_MMAP
+        std::string buffer;
+#endif
+
+        [[noreturn]] static void fail(const std::string& path) {
+            throw std::runtime_error("BigInt could not read " + path + ".");
+        }
+};
+
+// A file is parsed in segments of about this many bytes, each extended to
+// the end of the line it stops in. A block of a few segments per thread is
+// parsed at a time, which bounds the values held before they are handed
+// out.
+static const size_t LOAD_SEGMENT_BYTES = size_t(1) << 18;
+
+static const char* segment_end(const char* p, const char* end) {
+    if (size_t(end - p) <= LOAD_SEGMENT_BYTES) {
+        return end;
+    }
+    p += LOAD_SEGMENT_BYTES;
+    const void* nl = std::memchr(p, '\n', size_t(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// the value of the line s[0..len), an optional '-' and then decimal
+// digits; false if it is anything else
+static bool parse_line(const char* s, size_t len, DigitVector& digits,
+                       bool& negative) {
+    negative = len > 0 && s[0] == '-';
+    if (negative) {
+        ++s;
+        --len;
+    }
+    if (len == 0 || !all_decimal_digits(s, len)) {
+        return false;
+    }
+    from_decimal(s, len, digits);
+    return true;
+}
+
+// ^^^^^ bulk loading ^^^^^
+
+// ^^^^^^^^^^ HELPER FUNCTIONS ^^^^^^^^^^
+//
+// vvvvvvvvvv CONSTRUCTORS vvvvvvvvvv
+
+BigInt::BigInt()
+    : digits({0}), negative(false) { }
+
+BigInt::BigInt(const std::string& val) {
+    STATS_OPERATION(FROM_STRING, val.size() / DEC_CHUNK_DIGITS + 1);
+    if (val.empty()) {
+        throw std::invalid_argument(
+            "BigInt cannot be initialized from an empty string."
+        );
+    }
+
+    size_t first = 0;
+    if (val.front() == '-') {
+        if (val.size() == 1) {
+            throw std::invalid_argument(
+                "Initializer string must contain a decimal value."
+            );
+        }
+        first = 1;
+    }
+
+    const size_t len = val.size() - first;
+    if (!all_decimal_digits(val.data() + first, len)) {
+        throw std::invalid_argument("Bad initializer digit.");
+    }
+    from_decimal(val.data() + first, len, digits);
+
+    negative = first == 1 && !is_zero(digits);
+}
+
+BigInt::BigInt(const char* val)
+    : BigInt(std::string(val)) { }
+
+BigInt::BigInt(const DigitVector& digits_in, const bool negative_in)
+    : digits(digits_in), negative(negative_in) {
+    // zero is never negative
+    if (is_zero(digits)) {
+        negative = false;
+    }
+}
+
+BigInt::BigInt(DigitVector&& digits_in, const bool negative_in)
+    : digits(std::move(digits_in)), negative(negative_in) {
+    if (is_zero(digits)) {
+        negative = false;
+    }
+}
+
+// assign to a BigInt from a string representation of an integer
+//
+// * is this a good idea? I am implementing this with convenience
+// in mind, for example, to reassign to a previously-created BigInt a:
+// a = "12345"; (instead of/in addition to)
+// a = BigInt("12345");
+//
+// Is this confusing more than it is helpful?
+BigInt& BigInt::operator=(const std::string& val) {
+    return *this = BigInt(val);
+}
+
+BigInt::BigInt(const int val) {
+    // negate in 64 bits so that INT_MIN doesn't overflow
+    int64_t n = val;
+    digits = {uint64_t(n >= 0 ? n : -n)};
+    negative = val < 0;
+}
+
+BigInt& BigInt::operator=(const char* val) {
+    return *this = BigInt(std::string(val));
+}
+
+// ^^^^^^^^^^ CONSTRUCTORS ^^^^^^^^^^
+
+bool BigInt::is_negative() const {
+    return negative;
+}
+
+// design question: how long should an unitilialized BigInt be? Should
+// a BigInt even have a length attribute at all?
+//
+// Now that digits are binary, the decimal length is no longer the size of
+// the digits vector. A value of b bits lies in [2^(b-1), 2^b), so it has
+// either k = floor((b - 1) log10(2)) + 1 decimal digits (as 2^(b-1) does)
+// or one more, and a single comparison with 10^k settles which. log10(2)
+// is taken in 64-bit fixed point, which is exact enough for any b that
+// fits in memory.
+int BigInt::length() const {
+    const size_t bits = bit_length(digits);
+    if (bits <= 1) {
+        return 1;
+    }
+    const uint64_t LOG10_2 = 5553023288523357132ULL; // 2^64 log10(2)
+    const size_t k = size_t((uint128_t(bits - 1) * LOG10_2) >> 64) + 1;
+    if (k <= DEC_CHUNK_DIGITS) {
+        // then both the value and 10^k fit in a single digit
+        uint64_t p = 1;
+        for (size_t i = 0; i < k; ++i) {
+            p *= 10;
+        }
+        return int(digits[0] >= p ? k + 1 : k);
+    }
+    DigitVector p;
+    power(DigitVector(1, 10), unsigned(k), p);
+    return int(compare(digits, p) >= 0 ? k + 1 : k);
+}
+
+// vvvvvvvvvv ARITHMETIC-ASSIGNMENT OPERATORS vvvvvvvvvv
+
+BigInt& BigInt::operator+=(const BigInt& rhs) {
+    STATS_OPERATION(ADD, std::max(digits.size(), rhs.digits.size()));
+    add_signed_in_place(digits, negative, rhs.digits, rhs.negative);
+    return *this;
+}
+
+BigInt& BigInt::operator-=(const BigInt& rhs) {
+    STATS_OPERATION(SUBTRACT, std::max(digits.size(), rhs.digits.size()));
+    add_signed_in_place(digits, negative, rhs.digits, !rhs.negative);
+    return *this;
+}
+
+BigInt& BigInt::operator*=(const BigInt& rhs) {
+    STATS_OPERATION(MULTIPLY, std::max(digits.size(), rhs.digits.size()));
+    const bool neg = negative != rhs.negative;
+    if (rhs.digits.size() == 1) {
+        // a single-digit multiplier can be applied in place
+        mul_add_single_precision(digits, rhs.digits[0], 0);
+        rem_lzeros(digits);
+    }
+    else if (digits.size() == 1) {
+        const uint64_t m = digits[0];
+        digits = rhs.digits;
+        mul_add_single_precision(digits, m, 0);
+        rem_lzeros(digits);
+    }
+    else {
+        // the general product can't be formed over its own input
+        DigitVector product;
+        multiply(digits, rhs.digits, product);
+        digits = std::move(product);
+    }
+    negative = neg && !is_zero(digits);
+    return *this;
+}
+
+BigInt& BigInt::operator/=(const BigInt& rhs) {
+    return *this = *this / rhs;
+}
+
+BigInt& BigInt::operator%=(const BigInt& rhs) {
+    return *this = *this % rhs;
+}
+
+// ^^^^^^^^^^ ARITHMETIC-ASSIGNMENT OPERATORS ^^^^^^^^^^
+//
+// vvvvvvvvvv ARITHMETIC OPERAORS vvvvvvvvvv
+
+BigInt BigInt::operator+(const BigInt &rhs) const & {
+    STATS_OPERATION(ADD, std::max(digits.size(), rhs.digits.size()));
+    BigInt result;
+    add_signed(this->digits, this->negative, rhs.digits, rhs.negative,
+               result.digits, result.negative);
+    return result;
+}
+
+// the overloads for an expiring operand accumulate into it instead
+
+BigInt BigInt::operator+(const BigInt &rhs) && {
+    *this += rhs;
+    return std::move(*this);
+}
+
+BigInt BigInt::operator+(BigInt &&rhs) const & {
+    rhs += *this;
+    return std::move(rhs);
+}
+
+BigInt BigInt::operator+(BigInt &&rhs) && {
+    *this += rhs;
+    return std::move(*this);
+}
+
+BigInt BigInt::operator-(const BigInt &rhs) const & {
+    STATS_OPERATION(SUBTRACT, std::max(digits.size(), rhs.digits.size()));
+    BigInt result;
+    add_signed(this->digits, this->negative, rhs.digits, !rhs.negative,
+               result.digits, result.negative);
+    return result;
+}
+
+BigInt BigInt::operator-(const BigInt &rhs) && {
+    *this -= rhs;
+    return std::move(*this);
+}
+
+BigInt BigInt::operator-(BigInt &&rhs) const & {
+    STATS_OPERATION(SUBTRACT, std::max(digits.size(), rhs.digits.size()));
+    // a - b = -b + a; a negated zero is normalized by the addition
+    rhs.negative = !rhs.negative;
+    add_signed_in_place(rhs.digits, rhs.negative, digits, negative);
+    return std::move(rhs);
+}
+
+BigInt BigInt::operator-(BigInt &&rhs) && {
+    *this -= rhs;
+    return std::move(*this);
+}
+
+BigInt BigInt::operator*(const BigInt &rhs) const {
+    STATS_OPERATION(MULTIPLY, std::max(digits.size(), rhs.digits.size()));
+    BigInt result;
+    result.digits.clear();
+    if (!multiply_small(this->digits, rhs.digits, result.digits)) {
+        multiply(this->digits, rhs.digits, result.digits);
+    }
+    result.negative = this->is_negative() != rhs.is_negative() &&
+                      !is_zero(result.digits);
+    return result;
+}
+
+BigInt BigInt::operator/(const BigInt &rhs) const {
+    BigInt quotient, remainder;
+    divmod(*this, rhs, quotient, remainder);
+    return quotient;
+}
+
+BigInt BigInt::operator%(const BigInt &rhs) const {
+    BigInt quotient, remainder;
+    divmod(*this, rhs, quotient, remainder);
+    return remainder;
+}
+
+// the quotient is truncated toward zero and the remainder takes the sign of
+// the dividend, as for the built-in integer types, so that
+// quotient * divisor + remainder == dividend
+void BigInt::divmod(const BigInt& dividend, const BigInt& divisor,
+                    BigInt& quotient, BigInt& remainder) {
+    if (is_zero(divisor.digits)) {
+        throw std::domain_error("BigInt division by zero.");
+    }
+    STATS_OPERATION(DIVIDE, dividend.digits.size());
+    DigitVector q_digs, r_digs;
+    divide(dividend.digits, divisor.digits, q_digs, r_digs);
+    bool q_neg = dividend.is_negative() != divisor.is_negative();
+    bool r_neg = dividend.is_negative();
+    // the outputs may alias the inputs, so only assign them at the end
+    quotient = {std::move(q_digs), q_neg};
+    remainder = {std::move(r_digs), r_neg};
+}
+
+// multiplication recognizes a product of an operand with itself and
+// squares it instead
+BigInt BigInt::square() const {
+    return *this * *this;
+}
+
+BigInt BigInt::pow(const BigInt& base, unsigned exp) {
+    STATS_OPERATION(MULTIPLY, base.digits.size());
+    DigitVector result;
+    power(base.digits, exp, result);
+    return {std::move(result), base.negative && (exp & 1)};
+}
+
+// *this = the sum of (-1)^negate[j] terms[j] for j in [0, n), in a single
+// sweep. Each digit of the result is the signed sum of the terms' digits
+// in that place plus a signed carry, so the result is formed in two's
+// complement, one digit wider than the longest term (enough for any
+// n < 2^63), and only negated at the end if it came out negative. The
+// target may itself be a term: the digits it gains from resizing are
+// zeros, and each of its digits is read before it is overwritten.
+void BigInt::assign_sum(const BigInt* const* terms, const bool* negate,
+                        const size_t n) {
+    size_t width = 0;
+    for (size_t j = 0; j < n; ++j) {
+        width = std::max(width, terms[j]->digits.size());
+    }
+    ++width;
+    digits.resize(width, 0);
+
+    int128_t carry = 0;
+    for (size_t i = 0; i < width; ++i) {
+        int128_t t = carry;
+        for (size_t j = 0; j < n; ++j) {
+            const DigitVector& d = terms[j]->digits;
+            if (i < d.size()) {
+                if (terms[j]->negative != negate[j]) {
+                    t -= d[i];
+                }
+                else {
+                    t += d[i];
+                }
+            }
+        }
+        digits[i] = uint64_t(t);
+        carry = t >> 64; // arithmetic shift: 0 or a borrow of -1 or more
+    }
+
+    // the carry out of the sign digit is its sign extension
+    assert(carry == 0 || carry == -1);
+    negative = carry < 0;
+    if (negative) {
+        negate_twos_complement(digits);
+    }
+    rem_lzeros(digits);
+    if (is_zero(digits)) {
+        negative = false;
+    }
+}
+
+// ^^^^^^^^^^ ARITHMETIC OPERATORS ^^^^^^^^^^
+
+// vvvvvvvvvv ACCUMULATOR vvvvvvvvvv
+
+// past this many values a column sum could overflow, so the columns are
+// normalized first
+static const uint64_t ACCUMULATOR_LIMIT = uint64_t(1) << 62;
+
+BigIntAccumulator::BigIntAccumulator()
+    : count(0) { }
+
+BigIntAccumulator& BigIntAccumulator::operator+=(const BigInt& x) {
+    add(x, false);
+    return *this;
+}
+
+BigIntAccumulator& BigIntAccumulator::operator-=(const BigInt& x) {
+    add(x, true);
+    return *this;
+}
+
+void BigIntAccumulator::add(const BigInt& x, const bool negate) {
+    if (count == ACCUMULATOR_LIMIT) {
+        BigInt t = total();
+        clear();
+        add(t, false);
+    }
+    ++count;
+
+    const size_t n = x.digits.size();
+    if (lo.size() < n) {
+        lo.resize(n, 0);
+        hi.resize(n, 0);
+    }
+    const uint64_t* d = x.digits.data();
+    uint64_t* l = lo.data();
+    uint64_t* h = hi.data();
+    // no carries between columns, so no iteration waits on the last
+    if (x.negative == negate) {
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t s = l[i] + d[i];
+            h[i] += s < d[i] ? 1 : 0;
+            l[i] = s;
+        }
+    }
+    else {
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t s = l[i] - d[i];
+            h[i] -= s > l[i] ? 1 : 0;
+            l[i] = s;
+        }
+    }
+}
+
+BigInt BigIntAccumulator::total() const {
+    // two more digits than columns hold the top column's high half and
+    // the carry out of it; the last is the sign
+    const size_t n = lo.size();
+    DigitVector r(n + 2, 0);
+    int128_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int128_t t = int128_t((uint128_t(hi[i]) << 64) | lo[i]) + carry;
+        r[i] = uint64_t(t);
+        carry = t >> 64;
+    }
+    r[n] = uint64_t(carry);
+    carry >>= 64;
+    r[n + 1] = uint64_t(carry);
+    assert(carry == 0 || carry == -1);
+
+    bool negative = carry < 0;
+    if (negative) {
+        negate_twos_complement(r);
+    }
+    rem_lzeros(r);
+    return BigInt(std::move(r), negative);
+}
+
+void BigIntAccumulator::clear() {
+    lo.clear();
+    hi.clear();
+    count = 0;
+}
+
+// ^^^^^^^^^^ ACCUMULATOR ^^^^^^^^^^
+
+// vvvvvvvvvv MEMORY RESOURCES vvvvvvvvvv
+
+std::pmr::memory_resource* BigInt::memory_resource() {
+    std::pmr::memory_resource* r = DigitVector::current_resource();
+    return r ? r : std::pmr::new_delete_resource();
+}
+
+std::pmr::memory_resource* BigInt::set_memory_resource(
+        std::pmr::memory_resource* r) {
+    std::pmr::memory_resource* previous = memory_resource();
+    // the default is kept as null so that DigitVector uses new[] directly
+    DigitVector::current_resource() =
+        r == std::pmr::new_delete_resource() ? nullptr : r;
+    return previous;
+}
+
+BigIntArena::BigIntArena(const size_t initial_size)
+    : region(initial_size), pool(&region),
+      previous(DigitVector::current_resource()) {
+    DigitVector::current_resource() = &pool;
+}
+
+BigIntArena::~BigIntArena() {
+    assert(DigitVector::current_resource() == &pool);
+    DigitVector::current_resource() = previous;
+}
+
+std::pmr::memory_resource* BigIntArena::resource() {
+    return &pool;
+}
+
+void BigIntArena::release() {
+    pool.release();
+    region.release();
+}
+
+// ^^^^^^^^^^ MEMORY RESOURCES ^^^^^^^^^^
+//
+// vvvvvvvvvv THREADS vvvvvvvvvv
+
+void BigInt::set_threads(unsigned n) {
+    if (n == 0) {
+        n = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    if (n != thread_pool().size()) {
+        thread_pool().resize(n);
+    }
+}
+
+unsigned BigInt::threads() {
+    return thread_pool().size();
+}
+
+void BigInt::set_parallel_threshold(const size_t digits) {
+    parallel_min_digits = digits;
+}
+
+size_t BigInt::parallel_threshold() {
+    return parallel_min_digits;
+}
+
+// ^^^^^^^^^^ THREADS ^^^^^^^^^^
+//
+// vvvvvvvvvv BATCH OPERATIONS vvvvvvvvvv
+
+// body(i) for i in [0, n), split into contiguous chunks of about equal
+// total cost(i) and spread across the pool. There are several chunks per
+// thread, so a thread that finishes early takes another rather than
+// waiting on a slow one.
+template <class Cost, class F>
+static void for_each_balanced(const size_t n, const Cost& cost,
+                              const F& body) {
+    ThreadPool& pool = thread_pool();
+    std::vector<size_t> bounds = {0};
+    if (pool.size() > 1) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += cost(i);
+        }
+        const uint64_t target = total / (8 * pool.size()) + 1;
+        uint64_t chunk_cost = 0;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            chunk_cost += cost(i);
+            if (chunk_cost >= target) {
+                bounds.push_back(i + 1);
+                chunk_cost = 0;
+            }
+        }
+    }
+    if (n > 0) {
+        bounds.push_back(n);
+    }
+    auto chunk = [&](const size_t c) {
+        BigIntArena scratch;
+        for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+            body(i);
+        }
+    };
+    pool.parallel_for(bounds.size() - 1, std::cref(chunk));
+}
+
+// Outputs are written by whichever thread runs their chunk, so any whose
+// buffers come from a memory resource (which needn't be thread-safe) are
+// grown to the result's size beforehand, on the calling thread.
+static void reserve_output(DigitVector& out, const size_t digits) {
+    if (out.get_resource() && thread_pool().size() > 1) {
+        out.reserve(digits);
+    }
+}
+
+void BigInt::multiply_batch(const BigInt* a, const BigInt* b, BigInt* out,
+                            const size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        reserve_output(out[i].digits,
+                       a[i].digits.size() + b[i].digits.size());
+    }
+    auto cost = [&](const size_t i) {
+        return uint64_t(a[i].digits.size()) * b[i].digits.size();
+    };
+    for_each_balanced(n, cost, [&](const size_t i) {
+        BigInt& r = out[i];
+        if (&r == &a[i] || &r == &b[i]) {
+            r = a[i] * b[i];
+            return;
+        }
+        STATS_OPERATION(MULTIPLY,
+                        std::max(a[i].digits.size(), b[i].digits.size()));
+        // formed straight into r's buffer
+        r.digits.clear();
+        if (!multiply_small(a[i].digits, b[i].digits, r.digits)) {
+            multiply(a[i].digits, b[i].digits, r.digits);
+        }
+        r.negative = a[i].negative != b[i].negative && !is_zero(r.digits);
+    });
+}
+
+void BigInt::add_batch(const BigInt* a, const BigInt* b, BigInt* out,
+                       const size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        reserve_output(out[i].digits,
+                       std::max(a[i].digits.size(), b[i].digits.size()) + 1);
+    }
+    auto cost = [&](const size_t i) {
+        return uint64_t(a[i].digits.size()) + b[i].digits.size();
+    };
+    for_each_balanced(n, cost, [&](const size_t i) {
+        BigInt& r = out[i];
+        if (&r == &b[i]) {
+            r += a[i];
+        }
+        else {
+            if (&r != &a[i]) {
+                r = a[i];
+            }
+            r += b[i];
+        }
+    });
+}
+
+void BigInt::to_string_batch(const BigInt* a, std::string* out,
+                             const size_t n) {
+    auto cost = [&](const size_t i) {
+        return uint64_t(a[i].digits.size()) * a[i].digits.size();
+    };
+    for_each_balanced(n, cost, [&](const size_t i) {
+        out[i] = a[i].to_string();
+    });
+}
+
+// ^^^^^^^^^^ BATCH OPERATIONS ^^^^^^^^^^
+//
+// vvvvvvvvvv MODULAR EXPONENTIATION vvvvvvvvvv
+
+BigInt BigInt::powmod(const BigInt& base, const BigInt& exp,
+                      const BigInt& mod) {
+    if (mod.is_negative() || is_zero(mod.digits)) {
+        throw std::domain_error("BigInt powmod modulus must be positive.");
+    }
+    if (mod.digits[0] & 1) {
+        return MontgomeryContext(mod).powmod(base, exp);
+    }
+    if (exp.is_negative()) {
+        throw std::domain_error("BigInt powmod exponent must be nonnegative.");
+    }
+
+    // an even modulus reduces by Barrett's method, squaring and
+    // multiplying from the top bit of the exponent down
+    const BarrettReducer reducer(mod);
+    const BigInt x = reducer.reduce(base);
+    BigInt result = reducer.reduce(1);
+    for (size_t i = bit_length(exp.digits); i-- > 0; ) {
+        result = reducer.reduce(result * result);
+        if (test_bit(exp.digits, i)) {
+            result = reducer.reduce(result * x);
+        }
+    }
+    return result;
+}
+
+MontgomeryContext::MontgomeryContext(const BigInt& modulus)
+    : n(modulus) {
+    if (n.is_negative() || !(n.digits[0] & 1)) {
+        throw std::domain_error(
+            "MontgomeryContext modulus must be odd and positive.");
+    }
+    const size_t k = n.digits.size();
+    n_inv = -inverse_mod_base(n.digits[0]);
+
+    // R^2 = b^(2k), reduced by a single division
+    DigitVector r_sq(2 * k + 1, 0), q;
+    r_sq[2 * k] = 1;
+    divide(r_sq, n.digits, q, r2);
+    r2.resize(k, 0);
+}
+
+const BigInt& MontgomeryContext::modulus() const {
+    return n;
 }
 
-// base routine for adding two nonnegative integers
-// REQUIRES: This method assumes that result is an empty vector to which digits
-//           from the result will be appended as they are computed.
-static void add(const std::vector<int>& lhs,
-                const std::vector<int>& rhs,
-                std::vector<int>& result, const int base) {
-    assert(result.size() == 0);
-    size_t i = 0;
-    size_t j = 0;
-    int carry = 0;
-    while (i < lhs.size() || j < rhs.size()) {
-        int partial_sum = carry;
-        if (i < lhs.size()) {
-            partial_sum += lhs[i];
-            ++i;
-        }
-        if (j < rhs.size()) {
-            partial_sum += rhs[j];
-            ++j;
-        }
-        result.push_back(partial_sum % base);
-        carry = int(partial_sum / base);
+// Left-to-right sliding window exponentiation: the exponent is read from
+// the top bit down as zeros, each costing a squaring, and windows of up
+// to w bits that start and end with a one, each costing a squaring per
+// bit and one multiplication by a precomputed odd power of the base.
+BigInt MontgomeryContext::powmod(const BigInt& base, const BigInt& exp) const {
+    if (exp.is_negative()) {
+        throw std::domain_error("BigInt powmod exponent must be nonnegative.");
     }
-    if (carry) {
-        result.push_back(carry);
+    const uint64_t* nd = n.digits.data();
+    const size_t k = n.digits.size();
+    const size_t exp_bits = bit_length(exp.digits);
+    if (exp_bits == 0) {
+        return BigInt(1) % n;
     }
-}
 
-// base routine for subtracting two nonnegative integers
-// REQUIRES: This method assumes that result is an empty vector to which digits
-//           from the result will be appended as they are computed.
-static void subtract(const std::vector<int>& lhs,
-                     const std::vector<int>& rhs,
-                     std::vector<int>& result, const int base) {
-    assert(result.size() == 0);
-    size_t i = 0;
-    size_t j = 0;
-    int borrow = 0;
-    while (i < lhs.size() || j < rhs.size()) {
-        int partial_sub = borrow;
-        if (i < lhs.size()) {
-            partial_sub += lhs[i];
-            ++i;
+    BigInt x = base % n;
+    if (x.is_negative()) {
+        x += n;
+    }
+    DigitVector t(2 * k, 0);
+
+    // table[j] = base^(2j + 1) R mod n
+    const unsigned w = window_bits(exp_bits);
+    const size_t table_size = size_t(1) << (w - 1);
+    DigitVector table(table_size * k, 0), acc(k, 0);
+    std::copy(x.digits.begin(), x.digits.end(), acc.begin());
+    mont_mul(table.data(), acc.data(), r2.data(), nd, k, n_inv, t.data());
+    if (table_size > 1) {
+        DigitVector sq(k);
+        mont_mul(sq.data(), table.data(), table.data(), nd, k, n_inv,
+                 t.data());
+        for (size_t j = 1; j < table_size; ++j) {
+            mont_mul(table.data() + j * k, table.data() + (j - 1) * k,
+                     sq.data(), nd, k, n_inv, t.data());
+        }
+    }
+
+    // the top bit is a one, so the first window initializes acc
+    bool started = false;
+    size_t i = exp_bits; // bits [0, i) are still to be read
+    while (i > 0) {
+        if (!test_bit(exp.digits, i - 1)) {
+            mont_mul(acc.data(), acc.data(), acc.data(), nd, k, n_inv,
+                     t.data());
+            --i;
+            continue;
+        }
+        // the window is bits [lo, i), ending in a one
+        size_t lo = i > w ? i - w : 0;
+        while (!test_bit(exp.digits, lo)) {
+            ++lo;
+        }
+        size_t value = 0;
+        for (size_t j = i; j-- > lo; ) {
+            value = 2 * value + (test_bit(exp.digits, j) ? 1 : 0);
         }
-        if (j < rhs.size()) {
-            partial_sub -= rhs[j];
-            ++j;
+        const uint64_t* power = table.data() + (value / 2) * k;
+        if (started) {
+            for (size_t j = lo; j < i; ++j) {
+                mont_mul(acc.data(), acc.data(), acc.data(), nd, k, n_inv,
+                         t.data());
+            }
+            mont_mul(acc.data(), acc.data(), power, nd, k, n_inv, t.data());
+        }
+        else {
+            std::copy(power, power + k, acc.data());
+            started = true;
         }
-        result.push_back(mod(partial_sub, base));
-        borrow = int(std::floor(float(partial_sub) / base));
+        i = lo;
     }
-    assert(borrow == 0);
-    rem_lzeros(result);
+
+    // out of Montgomery form: REDC(acc) = acc R^-1
+    std::copy(acc.begin(), acc.end(), t.begin());
+    std::fill(t.begin() + k, t.end(), uint64_t(0));
+    mont_reduce(acc.data(), t.data(), nd, k, n_inv);
+    rem_lzeros(acc);
+    return BigInt(std::move(acc), false);
 }
 
-// base routine for mutliplying two nonnegative integers
-// REQUIRES: This method assumes that result is an empty vector to which digits
-//           from the result will be appended as they are computed.
-static void multiply(const std::vector<int>& lhs,
-                     const std::vector<int>& rhs,
-                     std::vector<int>& result, const int base) {
-    assert(result.size() == 0);
+// ^^^^^^^^^^ MODULAR EXPONENTIATION ^^^^^^^^^^
+//
+// vvvvvvvvvv BARRETT REDUCTION vvvvvvvvvv
 
-    int k;
-    for (size_t i = 0; i < lhs.size() + rhs.size(); ++i) {
-        result.push_back(0);
-    }
-    for (size_t j = 0; j < rhs.size(); ++j) {
-        k = 0;
-        for (size_t i = 0; i < lhs.size(); ++i) {
-            int t = lhs[i] * rhs[j] + result[i + j] + k;
-            result[i + j] = mod(t, base);
-            k = int(t / base);
-        }
-        result[lhs.size() + j] = k;
+BarrettReducer::BarrettReducer(const BigInt& modulus)
+    : n(modulus) {
+    if (n.is_negative() || is_zero(n.digits)) {
+        throw std::domain_error("BarrettReducer modulus must be positive.");
     }
-    rem_lzeros(result);
+    const size_t k = n.digits.size();
+    DigitVector b_2k(2 * k + 1, 0), rem;
+    b_2k[2 * k] = 1;
+    divide(b_2k, n.digits, mu, rem);
 }
 
-// a simpler division algorithm for the case when the divisor is
-// of single precision (i.e. 1 < divisor < base)
-static void divide_single_precision(const std::vector<int>& lhs,
-                                      const std::vector<int>& rhs,
-                                      std::vector<int>& result,
-                                      const int base) {
-    assert(rhs.size() == 1 && rhs[0] != 0);
-    // there must be a better way to implement this algorithm that doesn't
-    // require resizing the result vector before calculating (O(n)) and then
-    // iterating through it to compute and insert digits (O(n))
-    result.resize(lhs.size());
-    assert(result.size() == lhs.size());
-    int v = rhs[0];
-    int d_partial = 0;
-    for (size_t i = lhs.size(); i-- > 0; ) {
-        d_partial = d_partial * base + lhs[i];
-        int digit = d_partial / v;
-        result[i] = digit;
-        d_partial -= digit * v;
-    }
-    rem_lzeros(result);
-    // should this function return the remainder somehow??
+const BigInt& BarrettReducer::modulus() const {
+    return n;
 }
 
-// base routine for dividing two nonnegative integers
-// from Knuth, The Art of Computer Programming (Seminumerical Algorithms):
-//
-// given nonnegative integers
-//      u = (u_{m+n-1}...u_{0})_{b}
-//      and
-//      v = (v{n-1}...v_{0})_{b},
-// where the leading digit of v n.e. 0 and n > 1,
-// this recipe forms the radix-b quotient
-//      floor(u / v) = (q_{m}...q_{0})_{b}
-// and the remainder
-//      u mod v = (r_{n-1}...r_{0})_{b}.
-//
-static void divide(const std::vector<int>& lhs,
-                   const std::vector<int>& rhs,
-                   std::vector<int>& result, const int base) {
-    if (rhs.size() == 1) {
-        divide_single_precision(lhs, rhs, result, base);
-        return;
+// from Menezes, van Oorschot and Vanstone, Handbook of Applied
+// Cryptography, Algorithm 14.42: for x < b^(2k),
+//      q = floor(floor(x / b^(k-1)) mu / b^(k+1))
+// is at most 2 below floor(x / n), so r = x - q n is below 3n, and it
+// can be found modulo b^(k+1) from the low k + 1 digits of x and of q n.
+// Leaving the partial products below place k - 1 out of the estimate
+// (note 14.44) costs at most one more subtraction of n.
+BigInt BarrettReducer::reduce(const BigInt& x) const {
+    const DigitVector& xd = x.digits;
+    const size_t k = n.digits.size();
+    const size_t xn = xd.size();
+    DigitVector r;
+    if (xn > 2 * k) {
+        DigitVector q;
+        divide(xd, n.digits, q, r);
+    }
+    else if (compare(xd, n.digits) < 0) {
+        r = xd;
     }
     else {
-      assert(false);
+        // q = the top of x times mu, shifted down
+        // q is the top of the product q2, with room for q n after it
+        const size_t q1n = xn - (k - 1);
+        const size_t q2n = q1n + mu.size();
+        DigitVector scratch(q2n + k + 1);
+        uint64_t* q2 = scratch.data();
+        uint64_t* qn = q2 + q2n;
+        mul_high(q2, xd.data() + k - 1, q1n, mu.data(), mu.size(), k);
+        const uint64_t* q = q2 + k + 1;
+        size_t q_len = q2n - (k + 1);
+        while (q_len > 0 && q[q_len - 1] == 0) {
+            --q_len;
+        }
+
+        // r = x - q n modulo b^(k+1), which r is known to be below
+        r.assign(k + 1, 0);
+        std::copy(xd.begin(), xd.begin() + std::min(xn, k + 1), r.begin());
+        if (q_len > 0) {
+            mul_low(qn, q, q_len, n.digits.data(), k, k + 1);
+            sub_n(r.data(), r.data(), qn, k + 1);
+        }
+        rem_lzeros(r);
+        while (compare(r, n.digits) >= 0) {
+            sub_in_place(r, n.digits);
+        }
     }
+    if (x.is_negative() && !is_zero(r)) {
+        rsub_in_place(r, n.digits);
+    }
+    return BigInt(std::move(r), false);
 }
 
-// ^^^^^^^^^^ HELPER FUNCTIONS ^^^^^^^^^^
+// ^^^^^^^^^^ BARRETT REDUCTION ^^^^^^^^^^
 //
-// vvvvvvvvvv CONSTRUCTORS vvvvvvvvvv
+// vvvvvvvvvv GREATEST COMMON DIVISORS vvvvvvvvvv
 
-BigInt::BigInt()
-    : digits({0}), negative(false) { }
+BigInt BigInt::gcd(const BigInt& a, const BigInt& b) {
+    DigitVector c = a.digits, d = b.digits;
+    gcd_reduce(c, d, nullptr);
+    return {is_zero(c) ? std::move(d) : std::move(c), false};
+}
 
-BigInt::BigInt(const std::string& val) {
-    if (val.empty()) {
-        throw std::invalid_argument(
-            "BigInt cannot be initialized from an empty string."
-        );
+// With (c, d) = M^-1 (|a|, |b|) at the end, for M^-1 = [m11 -m01; -m10
+// m00], the gcd is c = m11 |a| - m01 |b| if d is zero and otherwise
+// d = m00 |b| - m10 |a|.
+BigInt BigInt::extended_gcd(const BigInt& a, const BigInt& b,
+                            BigInt& x, BigInt& y) {
+    DigitVector c = a.digits, d = b.digits;
+    GcdMatrix M;
+    gcd_reduce(c, d, &M);
+    BigInt g, s, t;
+    if (is_zero(d)) {
+        g = {std::move(c), false};
+        s = {std::move(M.m11), a.negative};
+        t = {std::move(M.m01), !b.negative};
+    }
+    else {
+        g = {std::move(d), false};
+        s = {std::move(M.m10), !a.negative};
+        t = {std::move(M.m00), b.negative};
     }
+    // the outputs may alias the inputs, so only assign them at the end
+    x = std::move(s);
+    y = std::move(t);
+    return g;
+}
 
-    if (val.front() == '-') {
-        if (val.size() == 1) {
-            throw std::invalid_argument(
-                "Initializer string must contain a decimal value."
-            );
-        }
-        negative = true;
+BigInt BigInt::modinv(const BigInt& a, const BigInt& m) {
+    if (m.negative || is_zero(m.digits)) {
+        throw std::domain_error("BigInt modinv modulus must be positive.");
     }
-    else {
-        negative = false;
+    BigInt r = a % m;
+    if (r.negative) {
+        r += m;
     }
+    BigInt x, y;
+    if (extended_gcd(r, m, x, y) != BigInt(1)) {
+        throw std::domain_error("BigInt modinv argument is not invertible.");
+    }
+    x %= m;
+    if (x.negative) {
+        x += m;
+    }
+    return x;
+}
 
-    for (auto it = val.rbegin(); it != val.rend(); ++it) {
-        if (*it == '-' && next(it) == val.rend()) {
-            continue;
-        }
+// ^^^^^^^^^^ GREATEST COMMON DIVISORS ^^^^^^^^^^
+//
+// vvvvvvvvvv INTEGER ROOTS vvvvvvvvvv
 
-        if (*it < '0' || *it - '0' >= BASE) {
-            throw std::invalid_argument("Bad initializer digit.");
-        }
+BigInt BigInt::isqrt(const BigInt& n) {
+    BigInt rem;
+    return isqrt_rem(n, rem);
+}
 
-        digits.push_back(*it - '0');
+BigInt BigInt::isqrt_rem(const BigInt& n, BigInt& rem) {
+    if (n.negative) {
+        throw std::domain_error("BigInt isqrt of a negative number.");
     }
+    DigitVector s, r;
+    sqrt_rem(n.digits, s, r);
+    // rem may alias n, so only assign it at the end
+    rem = {std::move(r), false};
+    return {std::move(s), false};
 }
 
-BigInt::BigInt(const char* val)
-    : BigInt(std::string(val)) { }
-
-BigInt::BigInt(const std::vector<int>& digits_in, const bool negative_in)
-    : digits(digits_in), negative(negative_in) { }
+// for odd k, the root of -n is minus the root of n
+BigInt BigInt::iroot(const BigInt& n, unsigned k) {
+    if (k == 0) {
+        throw std::domain_error("BigInt iroot of degree zero.");
+    }
+    if (n.negative && k % 2 == 0) {
+        throw std::domain_error("BigInt iroot of even degree of a negative "
+                                "number.");
+    }
+    if (k == 1) {
+        return n;
+    }
+    DigitVector s;
+    root(n.digits, k, s);
+    return {std::move(s), n.negative};
+}
 
-// assign to a BigInt from a string representation of an integer
-//
-// * is this a good idea? I am implementing this with convenience
-// in mind, for example, to reassign to a previously-created BigInt a:
-// a = "12345"; (instead of/in addition to)
-// a = BigInt("12345");
+// ^^^^^^^^^^ INTEGER ROOTS ^^^^^^^^^^
 //
-// Is this confusing more than it is helpful?
-BigInt& BigInt::operator=(const std::string& val) {
-    return *this = BigInt(val);
+// vvvvvvvvvv BINARY FORMAT vvvvvvvvvv
+
+size_t BigInt::serialized_size() const {
+    return SERIAL_HEADER_BYTES + 8 * digits.size();
 }
 
-BigInt::BigInt(const int val) {
-    int n = val >= 0 ? val : -val;
-    while (n > 0) {
-        int dig = n % 10;
-        n = (n - dig) / 10;
-        digits.push_back(dig);
+void BigInt::serialize(std::vector<unsigned char>& buffer) const {
+    const size_t start = buffer.size();
+    buffer.resize(start + serialized_size());
+    unsigned char* p = buffer.data() + start;
+    p[0] = SERIAL_VERSION;
+    p[1] = negative ? 1 : 0;
+    std::fill(p + 2, p + 8, 0);
+    store_le64(p + 8, digits.size());
+    p += SERIAL_HEADER_BYTES;
+    if (LITTLE_ENDIAN_HOST) {
+        std::memcpy(p, digits.data(), 8 * digits.size());
+    }
+    else {
+        for (size_t i = 0; i < digits.size(); ++i) {
+            store_le64(p + 8 * i, digits[i]);
+        }
     }
-    negative = val < 0;
 }
 
-BigInt& BigInt::operator=(const char* val) {
-    return *this = BigInt(std::string(val));
+BigInt BigInt::deserialize(const unsigned char* data, const size_t size,
+                           size_t* used) {
+    bool neg;
+    size_t count;
+    read_header(data, size, neg, count);
+    const unsigned char* p = data + SERIAL_HEADER_BYTES;
+    DigitVector d(count);
+    if (LITTLE_ENDIAN_HOST) {
+        std::memcpy(d.data(), p, 8 * count);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            d[i] = load_le64(p + 8 * i);
+        }
+    }
+    if (used) {
+        *used = SERIAL_HEADER_BYTES + 8 * count;
+    }
+    return {std::move(d), neg};
 }
 
-// ^^^^^^^^^^ CONSTRUCTORS ^^^^^^^^^^
+BigIntView::BigIntView(const unsigned char* data, const size_t size) {
+    read_header(data, size, negative, n);
+    if (!LITTLE_ENDIAN_HOST
+            || reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) {
+        throw std::invalid_argument("BigInt binary record can't be viewed "
+                                    "in place.");
+    }
+    digits = reinterpret_cast<const uint64_t*>(data + SERIAL_HEADER_BYTES);
+}
 
-bool BigInt::is_negative() const {
+BigIntView::BigIntView(const BigInt& x)
+    : digits(x.digits.data()), n(x.digits.size()), negative(x.negative) { }
+
+bool BigIntView::is_negative() const {
     return negative;
 }
 
-// design question: how long should an unitilialized BigInt be? Should
-// a BigInt even have a length attribute at all?
-int BigInt::length() const {
-    return int(digits.size());
+size_t BigIntView::size() const {
+    return n;
 }
 
-// vvvvvvvvvv ARITHMETIC-ASSIGNMENT OPERATORS vvvvvvvvvv
+size_t BigIntView::serialized_size() const {
+    return SERIAL_HEADER_BYTES + 8 * n;
+}
 
-BigInt& BigInt::operator+=(const BigInt& rhs) {
-    // define in terms of the overloaded addition operator
-    return *this = *this + rhs;
+BigInt BigIntView::to_bigint() const {
+    return {DigitVector(digits, digits + n), negative};
 }
 
-BigInt& BigInt::operator-=(const BigInt& rhs) {
-    // define in terms of the overloaded subtraction operator
-    return *this = *this - rhs;
+int BigIntView::compare(const BigIntView& rhs) const {
+    if (negative != rhs.negative) {
+        return negative ? -1 : 1;
+    }
+    int c = n != rhs.n ? (n < rhs.n ? -1 : 1) : cmp_n(digits, rhs.digits, n);
+    return negative ? -c : c;
 }
 
-BigInt& BigInt::operator*=(const BigInt& rhs) {
-    // define in terms of the overloaded subtraction operator
-    return *this = *this * rhs;
+// result's digits may be what one of the views points into, in which case
+// the result is formed aside and moved in at the end. A sum can still go
+// in place if result has room for it, since it is formed digit by digit
+// from the same positions of its operands.
+
+void BigIntView::add_into(const BigIntView& rhs, BigInt& result) const {
+    const bool aliased = (result.digits.data() == digits ||
+                          result.digits.data() == rhs.digits) &&
+                         result.digits.capacity() <= std::max(n, rhs.n);
+    DigitVector tmp;
+    DigitVector& out = aliased ? tmp : result.digits;
+    add_signed_n(digits, n, negative, rhs.digits, rhs.n, rhs.negative,
+                 out, result.negative);
+    if (aliased) {
+        result.digits = std::move(tmp);
+    }
 }
 
-BigInt& BigInt::operator/=(const BigInt& rhs) {
-    assert(false);
+void BigIntView::multiply_into(const BigIntView& rhs, BigInt& result) const {
+    const bool aliased = result.digits.data() == digits ||
+                         result.digits.data() == rhs.digits;
+    DigitVector tmp;
+    DigitVector& out = aliased ? tmp : result.digits;
+    out.resize(n + rhs.n);
+    mul_n_m(out.data(), digits, n, rhs.digits, rhs.n);
+    rem_lzeros(out);
+    if (aliased) {
+        result.digits = std::move(tmp);
+    }
+    result.negative = negative != rhs.negative && !is_zero(result.digits);
 }
 
-// ^^^^^^^^^^ ARITHMETIC-ASSIGNMENT OPERATORS ^^^^^^^^^^
+// ^^^^^^^^^^ BINARY FORMAT ^^^^^^^^^^
 //
-// vvvvvvvvvv ARITHMETIC OPERAORS vvvvvvvvvv
+// vvvvvvvvvv BULK LOADING vvvvvvvvvv
 
-BigInt BigInt::operator+(const BigInt &rhs) const {
-    BigInt result;
-    std::vector<int> result_digs;
+std::vector<BigInt> BigInt::load_file(const std::string& path) {
+    std::vector<BigInt> values;
+    for_each_in_file(path, [&](BigInt& x) {
+        values.push_back(std::move(x));
+    });
+    return values;
+}
 
-    if (!(this->is_negative() || rhs.is_negative())) {
-        add(this->digits, rhs.digits, result_digs, BASE);
-        result = {result_digs, false};
+// Each segment's values are built by whichever thread parses it, so they
+// are only destroyed here on the calling thread (whose memory resource
+// they may have come from) once f has seen them.
+void BigInt::for_each_in_file(const std::string& path,
+                              const std::function<void(BigInt&)>& f) {
+    const FileContents file(path);
+    const char* const begin = file.begin();
+    const char* const end = file.end();
+    ThreadPool& pool = thread_pool();
+    const size_t per_block = pool.size() > 1 ? 4 * size_t(pool.size()) : 1;
+    std::vector<const char*> bounds;
+    std::vector<std::vector<BigInt>> values(per_block);
+    // the first malformed line of each segment, if any. The segments are
+    // parsed in any order, so rather than throwing from a worker (which
+    // would report whichever segment failed first), each one stops at its
+    // first bad line and the earliest is reported below.
+    std::vector<const char*> bad_line(per_block);
 
-    }
-    else if (this->is_negative() && rhs.is_negative()) {
-        add(this->digits, rhs.digits, result_digs, BASE);
-        result = {result_digs, true};
-    }
-    else {
-        if (this->is_negative()) {
-            result = rhs - (-(*this));
-        }
-        else {
-            result = *this - (-(rhs));
+    auto parse = [&](const size_t i) {
+        const char* line = bounds[i];
+        const char* const stop = bounds[i + 1];
+        while (line < stop) {
+            const void* nl = std::memchr(line, '\n', size_t(stop - line));
+            const char* line_end = nl ? static_cast<const char*>(nl) : stop;
+            size_t len = size_t(line_end - line);
+            if (len > 0 && line[len - 1] == '\r') {
+                --len;
+            }
+            if (len > 0) {
+                STATS_OPERATION(FROM_STRING, len / DEC_CHUNK_DIGITS + 1);
+                DigitVector d;
+                bool neg;
+                if (!parse_line(line, len, d, neg)) {
+                    bad_line[i] = line;
+                    return;
+                }
+                values[i].push_back(BigInt(std::move(d), neg));
+            }
+            line = nl ? line_end + 1 : stop;
         }
-    }
+    };
 
-    return result;
-}
-
-BigInt BigInt::operator-(const BigInt &rhs) const {
-    BigInt result;
-    std::vector<int> result_digs;
-    if(!(this->is_negative() || rhs.is_negative())) {
-        if (*this >= rhs) {
-            subtract(this->digits, rhs.digits, result_digs, BASE);
-            result = {result_digs, false};
-        }
-        else {
-            subtract(rhs.digits, this->digits, result_digs, BASE);
-            result = {result_digs, true};
-        }
-    }
-    else if (this->is_negative() && rhs.is_negative()) {
-        result = -rhs - -(*this);
-    }
-    else {
-        if (this->is_negative()) {
-            add(this->digits, rhs.digits, result_digs, BASE);
-            result = {result_digs, true};
+    const char* p = begin;
+    while (p < end) {
+        bounds.assign(1, p);
+        while (bounds.size() <= per_block && bounds.back() < end) {
+            bounds.push_back(segment_end(bounds.back(), end));
         }
-        else {
-            add(this->digits, rhs.digits, result_digs, BASE);
-            result = {result_digs, false};
+        const size_t n = bounds.size() - 1;
+        std::fill(bad_line.begin(), bad_line.end(), nullptr);
+        pool.parallel_for(n, std::cref(parse));
+        for (size_t i = 0; i < n; ++i) {
+            for (BigInt& x : values[i]) {
+                f(x);
+            }
+            values[i].clear();
+            if (bad_line[i]) {
+                const size_t number =
+                    size_t(std::count(begin, bad_line[i], '\n'));
+                throw std::invalid_argument(
+                    "BigInt: line " + std::to_string(number + 1) +
+                    " of " + path + " is not an integer.");
+            }
         }
+        p = bounds.back();
     }
-    return result;
-}
-
-BigInt BigInt::operator*(const BigInt &rhs) const {
-    BigInt result;
-    std::vector<int> result_digs;
-    multiply(this->digits, rhs.digits, result_digs, BASE);
-    bool neg = this->is_negative() == rhs.is_negative() ? false : true;
-    result = {result_digs, neg};
-    return result;
-}
-
-BigInt BigInt::operator/(const BigInt &rhs) const {
-    BigInt result;
-    std::vector<int> result_digs;
-    divide(this->digits, rhs.digits, result_digs, BASE);
-    bool neg = this->is_negative() == rhs.is_negative() ? false : true;
-    result = {result_digs, neg};
-    return result;
 }
 
-// ^^^^^^^^^^ ARITHMETIC OPERATORS ^^^^^^^^^^
+// ^^^^^^^^^^ BULK LOADING ^^^^^^^^^^
 //
 // vvvvvvvvvv UNARY OPERATORS vvvvvvvvvv
 
-BigInt BigInt::operator+() const {
+BigInt BigInt::operator+() const & {
     return BigInt(this->digits, this->negative);
 }
 
-BigInt BigInt::operator-() const {
+BigInt BigInt::operator+() && {
+    return std::move(*this);
+}
+
+BigInt BigInt::operator-() const & {
     bool negative_in = negative ? false : true;
     return BigInt(this->digits, negative_in);
 }
 
+BigInt BigInt::operator-() && {
+    if (!is_zero(digits)) {
+        negative = !negative;
+    }
+    return std::move(*this);
+}
+
 BigInt& BigInt::operator++() {
-    return *this += BigInt("1");
+    return *this += BigInt(1);
 }
 
 BigInt& BigInt::operator--() {
-    return *this -= BigInt("1");
+    return *this -= BigInt(1);
 }
 
 BigInt BigInt::operator++(int) {
     BigInt copy = *this;
-    *this += BigInt("1");
+    *this += BigInt(1);
     return copy;
 }
 
 BigInt BigInt::operator--(int) {
     BigInt copy = *this;
-    *this -= BigInt("1");
+    *this -= BigInt(1);
     return copy;
 }
 
@@ -363,20 +4557,8 @@ BigInt BigInt::operator--(int) {
 // vvvvvvvvv COMPARISON OPERATORS vvvvvvvvv
 
 bool BigInt::operator==(const BigInt &rhs) const {
-    if (this->digits.size() != rhs.digits.size() ||
-        this->is_negative() != rhs.is_negative()) {
-        return false;
-    }
-    else {
-        size_t i = 0;
-        while (i < this->digits.size() && i < rhs.digits.size()) {
-            if (this->digits[i] != rhs.digits[i]) {
-                return false;
-            }
-            ++i;
-        }
-        return true;
-    }
+    return this->is_negative() == rhs.is_negative() &&
+           compare(this->digits, rhs.digits) == 0;
 }
 
 bool BigInt::operator!=(const BigInt &rhs) const {
@@ -391,22 +4573,9 @@ bool BigInt::operator<(const BigInt &rhs) const {
         return false;
     }
     else { // *this and rhs have the same sign
-        if (this->digits.size() < rhs.digits.size()) {
-            return true;
-        }
-        else if (this->digits.size() > rhs.digits.size()) {
-            return false;
-        }
-        else {
-            size_t i = 0;
-            while (i < this->digits.size() && i < rhs.digits.size()) {
-                if (this->digits[i] < rhs.digits[i]) {
-                    return true;
-                }
-                ++i;
-            }
-            return false;
-        }
+        int cmp = compare(this->digits, rhs.digits);
+        // a larger magnitude means a smaller negative number
+        return this->is_negative() ? cmp > 0 : cmp < 0;
     }
 }
 
@@ -425,29 +4594,272 @@ bool BigInt::operator>=(const BigInt &rhs) const {
 // ^^^^^^^^^^ COMPARISON OPERATORS ^^^^^^^^^^
 
 std::string BigInt::to_string() const {
+    STATS_OPERATION(TO_STRING, digits.size());
     std::string s_out;
 
     if (is_negative()) {
         s_out.push_back('-');
     }
 
-    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
-        s_out.push_back(*it + '0');
-    }
-
+    write_decimal(digits, s_out);
     return s_out;
 }
 
-std::ostream& operator<<(std::ostream &os, const BigInt &val)
-{
+// Without a field width, the digits go to the stream in blocks as they are
+// produced; padding needs the whole text first.
+std::ostream& operator<<(std::ostream& os, const BigInt& val) {
+    const std::ostream::sentry sentry(os);
+    if (!sentry) {
+        return os;
+    }
+    STATS_OPERATION(TO_STRING, val.digits.size());
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::ios_base::fmtflags base = flags & std::ios_base::basefield;
+    const bool upper = (flags & std::ios_base::uppercase) != 0;
+    const std::streamsize width = os.width(0);
+
+    std::string out;
     if (val.is_negative()) {
-        os << '-';
+        out.push_back('-');
+    }
+    else if (flags & std::ios_base::showpos) {
+        out.push_back('+');
+    }
+    if ((flags & std::ios_base::showbase) && !is_zero(val.digits)) {
+        if (base == std::ios_base::hex) {
+            out.append(upper ? "0X" : "0x");
+        }
+        else if (base == std::ios_base::oct) {
+            out.push_back('0');
+        }
     }
+    const size_t prefix_len = out.size();
 
-    for (auto it = val.digits.rbegin(); it != val.digits.rend(); ++it)
-    {
-        os << *it;
+    std::ostream* stream = width > 0 ? nullptr : &os;
+    if (base == std::ios_base::hex || base == std::ios_base::oct) {
+        write_power_of_two_base(val.digits,
+                                base == std::ios_base::hex ? 4 : 3,
+                                upper, out, stream);
+    }
+    else {
+        write_decimal(val.digits, out, stream);
     }
 
+    if (width > 0 && size_t(width) > out.size()) {
+        const size_t fill = size_t(width) - out.size();
+        const std::ios_base::fmtflags adjust =
+            flags & std::ios_base::adjustfield;
+        const size_t at = adjust == std::ios_base::left ? out.size()
+                        : adjust == std::ios_base::internal ? prefix_len
+                        : 0;
+        out.insert(at, fill, os.fill());
+    }
+    os.write(out.data(), std::streamsize(out.size()));
     return os;
 }
+
+// Like the built-in integer extractors: leading whitespace is skipped
+// (unless std::noskipws), an optional sign is followed by digits in the
+// stream's base (with an optional "0x" in hexadecimal), and reading stops
+// at the first character that isn't a digit. With no base set (e.g.
+// std::setbase(0)), the prefix picks it as for integer literals: "0x" or
+// "0X" for hexadecimal, a leading 0 for octal, and decimal otherwise. If
+// there are no digits, val is set to zero and failbit is set.
+std::istream& operator>>(std::istream& is, BigInt& val) {
+    const std::istream::sentry sentry(is);
+    if (!sentry) {
+        return is;
+    }
+    STATS_OPERATION(FROM_STRING, 0);
+    typedef std::istream::traits_type traits;
+    const std::ios_base::fmtflags base =
+        is.flags() & std::ios_base::basefield;
+    int radix = base == std::ios_base::hex ? 16
+              : base == std::ios_base::oct ? 8
+              : base == std::ios_base::dec ? 10 : 0;
+    std::streambuf* buf = is.rdbuf();
+
+    std::ios_base::iostate state = std::ios_base::goodbit;
+    bool negative = false;
+    bool any = false;
+    int c = buf->sgetc();
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        c = buf->snextc();
+    }
+    if ((radix == 16 || radix == 0) && c == '0') {
+        any = true;
+        c = buf->snextc();
+        if (c == 'x' || c == 'X') {
+            radix = 16;
+            c = buf->snextc();
+        }
+        else if (radix == 0) {
+            radix = 8;
+        }
+    }
+    if (radix == 0) {
+        radix = 10;
+    }
+    DecimalReader decimal;
+    PowerOfTwoBaseReader binary(radix == 16 ? 4 : 3);
+    for (; !traits::eq_int_type(c, traits::eof()); c = buf->snextc()) {
+        const int v = digit_value(c, radix);
+        if (v < 0) {
+            break;
+        }
+        any = true;
+        if (radix == 10) {
+            decimal.push(char(c));
+        }
+        else {
+            binary.push(v);
+        }
+    }
+    if (traits::eq_int_type(c, traits::eof())) {
+        state |= std::ios_base::eofbit;
+    }
+
+    if (!any) {
+        val = BigInt();
+        state |= std::ios_base::failbit;
+    }
+    else {
+        DigitVector d;
+        if (radix == 10) {
+            decimal.finish(d);
+        }
+        else {
+            binary.finish(d);
+        }
+        STATS_DIGITS(d.size());
+        val = BigInt(std::move(d), negative);
+    }
+    is.setstate(state);
+    return is;
+}
+
+// vvvvvvvvvv STATISTICS vvvvvvvvvv
+
+BigIntStats BigIntStats::snapshot() {
+    BigIntStats s;
+#ifdef BIGINT_STATS
+    StatsRegistry& r = stats_registry();
+    const std::lock_guard<std::mutex> lock(r.mutex);
+    s = r.exited;
+    for (const ThreadStats* t : r.live) {
+        t->add_to(s);
+    }
+    // counters only grow, so the totals at the last reset can be taken off
+    for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+        s.operations[i].calls -= r.baseline.operations[i].calls;
+        s.operations[i].cycles -= r.baseline.operations[i].cycles;
+        for (size_t j = 0; j < SIZE_BUCKETS; ++j) {
+            s.operations[i].sizes[j] -= r.baseline.operations[i].sizes[j];
+        }
+    }
+    for (size_t i = 0; i < ALGORITHM_COUNT; ++i) {
+        s.algorithms[i] -= r.baseline.algorithms[i];
+    }
+    s.allocations -= r.baseline.allocations;
+    s.allocated_bytes -= r.baseline.allocated_bytes;
+#endif
+    return s;
+}
+
+// Other threads' counters can't be cleared without racing their updates,
+// so a reset records the current totals for snapshot() to subtract.
+void BigIntStats::reset() {
+#ifdef BIGINT_STATS
+    StatsRegistry& r = stats_registry();
+    const std::lock_guard<std::mutex> lock(r.mutex);
+    BigIntStats totals = r.exited;
+    for (const ThreadStats* t : r.live) {
+        t->add_to(totals);
+    }
+    r.baseline = totals;
+#endif
+}
+
+const char* BigIntStats::name(const Operation op) {
+    static const char* const names[OPERATION_COUNT] = {
+        "add", "subtract", "multiply", "divide", "from_string", "to_string"
+    };
+    return names[op];
+}
+
+const char* BigIntStats::name(const Algorithm a) {
+    static const char* const names[ALGORITHM_COUNT] = {
+        "mul_native", "mul_basecase", "sqr_basecase", "mul_unbalanced",
+        "mul_karatsuba", "mul_toom32", "mul_toom33", "mul_toom44",
+        "mul_ntt", "div_single", "div_knuth", "div_burnikel_ziegler"
+    };
+    return names[a];
+}
+
+std::string BigIntStats::to_text() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+        const OperationStats& op = operations[i];
+        if (op.calls == 0) {
+            continue;
+        }
+        out << name(Operation(i)) << ": " << op.calls << " calls, "
+            << op.cycles << " cycles\n";
+        for (size_t j = 0; j < SIZE_BUCKETS; ++j) {
+            if (op.sizes[j] == 0) {
+                continue;
+            }
+            out << "    ";
+            if (j == 0) {
+                out << "0 digits";
+            }
+            else if (j == SIZE_BUCKETS - 1) {
+                out << ">= " << (uint64_t(1) << (j - 1)) << " digits";
+            }
+            else {
+                out << (uint64_t(1) << (j - 1)) << "-"
+                    << (uint64_t(1) << j) - 1 << " digits";
+            }
+            out << ": " << op.sizes[j] << "\n";
+        }
+    }
+    for (size_t i = 0; i < ALGORITHM_COUNT; ++i) {
+        if (algorithms[i]) {
+            out << name(Algorithm(i)) << ": " << algorithms[i] << "\n";
+        }
+    }
+    if (allocations) {
+        out << "allocations: " << allocations << ", " << allocated_bytes
+            << " bytes\n";
+    }
+    return out.str();
+}
+
+// {"operations": {"add": {"calls": ..., "cycles": ..., "sizes": [...]},
+// ...}, "algorithms": {"mul_basecase": ..., ...}, "allocations": ...,
+// "allocated_bytes": ...}, where sizes has SIZE_BUCKETS entries
+std::string BigIntStats::to_json() const {
+    std::ostringstream out;
+    out << "{\"operations\": {";
+    for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+        const OperationStats& op = operations[i];
+        out << (i ? ", " : "") << "\"" << name(Operation(i))
+            << "\": {\"calls\": " << op.calls << ", \"cycles\": "
+            << op.cycles << ", \"sizes\": [";
+        for (size_t j = 0; j < SIZE_BUCKETS; ++j) {
+            out << (j ? ", " : "") << op.sizes[j];
+        }
+        out << "]}";
+    }
+    out << "}, \"algorithms\": {";
+    for (size_t i = 0; i < ALGORITHM_COUNT; ++i) {
+        out << (i ? ", " : "") << "\"" << name(Algorithm(i)) << "\": "
+            << algorithms[i];
+    }
+    out << "}, \"allocations\": " << allocations
+        << ", \"allocated_bytes\": " << allocated_bytes << "}";
+    return out.str();
+}
+
+// ^^^^^^^^^^ STATISTICS ^^^^^^^^^^
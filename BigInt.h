@@ -4,13 +4,21 @@
 // A class to represent arbitrary-precision integers.
 // by Andrew Kerr <kerrand@protonmail.com>, January 2022
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
-#include <vector>
+#include <memory_resource>
 #include <string>
+#include <vector>
+#include "DigitVector.h"
+
+template <size_t N> class BigIntSum; // see BigIntExpr.h
 
 class BigInt {
     public:
-        static const int BASE = 10;
+        // each digit of a BigInt is a full machine word, i.e. BigInts
+        // are stored in radix 2^DIGIT_BITS
+        static const int DIGIT_BITS = 64;
 
         BigInt(); // default ctor
         BigInt(const std::string& val); // ctor
@@ -20,24 +28,122 @@ class BigInt {
         BigInt& operator=(const std::string& val); // assignment from string
         BigInt& operator=(const char* val); // assignment from c-style string
 
+        // evaluation of a lazy sum (defined in BigIntExpr.h)
+        template <size_t N> BigInt(const BigIntSum<N>& sum);
+        template <size_t N> BigInt& operator=(const BigIntSum<N>& sum);
+
         bool is_negative() const;
-        int length() const;
+        int length() const; // number of decimal digits
 
         // arithmetic-assignment operators
         BigInt& operator+=(const BigInt& rhs);
         BigInt& operator-=(const BigInt& rhs);
         BigInt& operator*=(const BigInt& rhs);
         BigInt& operator/=(const BigInt& rhs);
+        BigInt& operator%=(const BigInt& rhs);
 
-        // arithmetic operators
-        BigInt operator+(const BigInt& rhs) const;
-        BigInt operator-(const BigInt& rhs) const;
+        // arithmetic operators; when an operand of + or - is an rvalue,
+        // its digits are reused for the result
+        BigInt operator+(const BigInt& rhs) const &;
+        BigInt operator+(const BigInt& rhs) &&;
+        BigInt operator+(BigInt&& rhs) const &;
+        BigInt operator+(BigInt&& rhs) &&;
+        BigInt operator-(const BigInt& rhs) const &;
+        BigInt operator-(const BigInt& rhs) &&;
+        BigInt operator-(BigInt&& rhs) const &;
+        BigInt operator-(BigInt&& rhs) &&;
         BigInt operator*(const BigInt& rhs) const;
         BigInt operator/(const BigInt& rhs) const;
+        BigInt operator%(const BigInt& rhs) const;
+
+        // *this * *this, in about two thirds of the time of a general
+        // product of the same size (x * x and x *= x square as well)
+        BigInt square() const;
+
+        // base^exp by repeated squaring, with 0^0 = 1. The result's size
+        // is estimated from base's bit length up front, so the squarings
+        // run in two buffers allocated once.
+        static BigInt pow(const BigInt& base, unsigned exp);
+
+        // quotient and remainder of a single division, truncating toward
+        // zero like the built-in operators; throws std::domain_error if
+        // divisor is zero
+        static void divmod(const BigInt& dividend, const BigInt& divisor,
+                           BigInt& quotient, BigInt& remainder);
+
+        // base^exp mod mod, in [0, mod); throws std::domain_error unless
+        // mod is positive and exp nonnegative. Odd moduli use Montgomery
+        // multiplication (see MontgomeryContext).
+        static BigInt powmod(const BigInt& base, const BigInt& exp,
+                             const BigInt& mod);
+
+        // the greatest common divisor of a and b, which is nonnegative,
+        // and zero only if both are
+        static BigInt gcd(const BigInt& a, const BigInt& b);
+
+        // gcd(a, b), also setting x and y so that a x + b y = gcd(a, b)
+        static BigInt extended_gcd(const BigInt& a, const BigInt& b,
+                                   BigInt& x, BigInt& y);
+
+        // the x in [0, m) with a x = 1 (mod m); throws std::domain_error
+        // unless m is positive and gcd(a, m) = 1
+        static BigInt modinv(const BigInt& a, const BigInt& m);
+
+        // floor(sqrt(n)), with isqrt_rem also setting rem = n - isqrt(n)^2;
+        // both throw std::domain_error if n is negative
+        static BigInt isqrt(const BigInt& n);
+        static BigInt isqrt_rem(const BigInt& n, BigInt& rem);
+
+        // the k-th root of n, truncated toward zero; throws
+        // std::domain_error if k is zero, or if n is negative and k even
+        static BigInt iroot(const BigInt& n, unsigned k);
+
+        // the sum of the BigInts in [first, last), with carries propagated
+        // once at the end (see BigIntAccumulator)
+        template <class InputIt>
+        static BigInt sum(InputIt first, InputIt last);
+
+        // the memory resource that BigInts created on the calling thread
+        // allocate their digits from; std::pmr::new_delete_resource()
+        // unless changed. set_memory_resource returns the previous
+        // resource, and nullptr restores the default. A BigInt keeps the
+        // resource it was created with for its whole lifetime.
+        static std::pmr::memory_resource* memory_resource();
+        static std::pmr::memory_resource* set_memory_resource(
+            std::pmr::memory_resource* r);
+
+        // the number of threads, counting the caller, that share the work
+        // of a multiplication whose smaller operand has at least
+        // parallel_threshold() digits (1000 unless changed). Karatsuba and
+        // Toom-Cook products run their sub-products in parallel, and the
+        // number-theoretic transform its convolutions and butterflies.
+        // The default of 1 starts no threads; set_threads(0) uses one per
+        // hardware thread. Neither should be changed while another thread
+        // is doing arithmetic.
+        static void set_threads(unsigned n);
+        static unsigned threads();
+        static void set_parallel_threshold(size_t digits);
+        static size_t parallel_threshold();
+
+        // elementwise out[i] = a[i] * b[i], a[i] + b[i] or
+        // a[i].to_string() for i in [0, n), shared among the threads set
+        // by set_threads() in chunks of about equal work that idle threads
+        // take in turn. Each chunk's temporaries come from a scratch
+        // BigIntArena that is reused from one element to the next, and
+        // each out[i] keeps its buffer if that is large enough. out[i] may
+        // be a[i] or b[i] but must not otherwise overlap the operands.
+        static void multiply_batch(const BigInt* a, const BigInt* b,
+                                   BigInt* out, size_t n);
+        static void add_batch(const BigInt* a, const BigInt* b,
+                              BigInt* out, size_t n);
+        static void to_string_batch(const BigInt* a, std::string* out,
+                                    size_t n);
 
         // unary operators
-        BigInt operator+() const;
-        BigInt operator-() const;
+        BigInt operator+() const &;
+        BigInt operator+() &&;
+        BigInt operator-() const &;
+        BigInt operator-() &&;
         BigInt& operator++();
         BigInt& operator--();
         BigInt operator++(int);
@@ -53,23 +159,316 @@ class BigInt {
         bool operator>=(const BigInt& rhs) const;
 
         std::string to_string() const;
+
+        // Stream insertion honors the base (std::dec, std::hex, std::oct),
+        // std::showbase, std::showpos, std::uppercase, and the field
+        // width, fill and adjustment. Negative values print as '-' and
+        // the magnitude in every base, not as a two's complement. Without
+        // a field width, long values are written in blocks as they are
+        // converted.
         friend std::ostream& operator<<(std::ostream& os,
                                         const BigInt& val);
 
+        // Stream extraction reads like the built-in integer types, in the
+        // stream's base, converting digits as they arrive.
+        friend std::istream& operator>>(std::istream& is, BigInt& val);
+
+        // The binary format is a 16-byte header followed by the digits.
+        // The header holds the format version (SERIAL_VERSION), a sign
+        // byte (0 or 1), six zero bytes, and the digit count as a
+        // little-endian 64-bit integer. The digits follow least
+        // significant first, each little-endian. Every record is a
+        // multiple of 8 bytes long, so records stored back to back in an
+        // aligned buffer keep their digits aligned and can be read in
+        // place by BigIntView.
+        static const unsigned char SERIAL_VERSION = 1;
+
+        // the number of bytes serialize() appends
+        size_t serialized_size() const;
+
+        // appends the binary form of *this to buffer
+        void serialize(std::vector<unsigned char>& buffer) const;
+
+        // the BigInt in the record at the start of [data, data + size),
+        // setting *used (if given) to the record's length in bytes;
+        // throws std::invalid_argument if the bytes don't start with a
+        // whole, well-formed record of this version
+        static BigInt deserialize(const unsigned char* data, size_t size,
+                                  size_t* used = nullptr);
+
+        // the integers in a text file of one decimal integer per line (an
+        // optional '-' and then digits; "\r\n" line ends and blank lines
+        // are fine), in order. The file is memory-mapped where the
+        // platform allows, and parsed a block of lines at a time, with
+        // each block's lines shared among the threads set by
+        // set_threads(). Throws std::runtime_error if the file can't be
+        // read, and std::invalid_argument naming the line if a line isn't
+        // an integer.
+        static std::vector<BigInt> load_file(const std::string& path);
+
+        // f(x) for each integer x in such a file, in order and on the
+        // calling thread, e.g. to sum or otherwise reduce them without
+        // holding them all at once; f may move from x
+        static void for_each_in_file(const std::string& path,
+                                     const std::function<void(BigInt&)>& f);
+
     private:
-        // BigInts are stored as an underlying vector of
-        // integers whose values are between 0 and 9 inclusive.
+        // BigInts are stored as an underlying vector of 64-bit
+        // unsigned integers, i.e. as digits in radix b = 2^64 (Knuth
+        // calls these "digits"; elsewhere they are often called limbs).
+        // The vector keeps up to two digits inline, so small BigInts
+        // don't allocate.
         // The digits are stored in least-significant digit order,
         // i.e. the first element in the digits vector represents
-        // the ones place, in hopes that this will provide good
-        // performance when adding more digits with calls to
-        // push_back(). I'm not sure if there is a better way to
-        // do this, but have considered storing digits in a deque.
-        std::vector<int> digits;
+        // the ones place. Apart from the value zero, which is stored
+        // as the single digit 0, there are never any leading zero
+        // digits. Conversion to and from decimal only happens at the
+        // edges (the string constructor and to_string()).
+        DigitVector digits;
+
+        BigInt(const DigitVector& digits_in, const bool negative_in);
+        BigInt(DigitVector&& digits_in, const bool negative_in);
 
-        BigInt(const std::vector<int>& digits_in, const bool negative_in);
+        // *this = the sum of the terms, each negated if its flag is set,
+        // in a single carry sweep; *this may be one of the terms
+        void assign_sum(const BigInt* const* terms, const bool* negate,
+                        const size_t n);
 
         bool negative;
+
+        friend class BigIntAccumulator;
+        friend class MontgomeryContext;
+        friend class BarrettReducer;
+        friend class BigIntView;
+};
+
+// A running sum of many BigInts. Each digit of each value is added into
+// a 128-bit sum for its column, without carrying into the next column,
+// so an addition is a single pass over the value's digits that doesn't
+// depend on the accumulator's other columns. Carries are propagated only
+// when total() is called.
+class BigIntAccumulator {
+    public:
+        BigIntAccumulator();
+
+        BigIntAccumulator& operator+=(const BigInt& x);
+        BigIntAccumulator& operator-=(const BigInt& x);
+
+        BigInt total() const;
+        void clear();
+
+    private:
+        // column i holds the two's complement 128-bit value hi[i] b + lo[i]
+        DigitVector lo;
+        DigitVector hi;
+        // values added since the columns were last normalized; a column
+        // can't overflow before 2^62 of them
+        uint64_t count;
+
+        void add(const BigInt& x, const bool negate);
+};
+
+template <class InputIt>
+BigInt BigInt::sum(InputIt first, InputIt last) {
+    BigIntAccumulator acc;
+    for (; first != last; ++first) {
+        acc += *first;
+    }
+    return acc.total();
+}
+
+// A pool of digit buffers for a batch of BigInt work on one thread.
+// While a BigIntArena exists it is the thread's BigInt memory resource:
+// BigInts (and the temporaries of the arithmetic on them) created in the
+// meantime allocate from a pool carved out of one growing region, and
+// everything is handed back at once when the arena is destroyed or
+// released. Buffers too large for the pool's size classes are not
+// reused until then.
+//
+// Arenas nest, and must be destroyed in reverse order of creation, on
+// the thread that created them. A BigInt allocated from an arena must not
+// outlive it; to keep a result, assign it to a BigInt created before the
+// arena (assignment copies the digits into that BigInt's own resource).
+class BigIntArena {
+    public:
+        explicit BigIntArena(const size_t initial_size = 64 * 1024);
+        ~BigIntArena(); // restores the previous resource
+
+        BigIntArena(const BigIntArena&) = delete;
+        BigIntArena& operator=(const BigIntArena&) = delete;
+
+        std::pmr::memory_resource* resource();
+
+        // frees every buffer allocated from the arena at once, for reuse
+        // across batches; no BigInt allocated from it may still exist
+        void release();
+
+    private:
+        std::pmr::monotonic_buffer_resource region;
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::memory_resource* previous;
+};
+
+// Precomputed values for arithmetic modulo a fixed odd modulus n in
+// Montgomery form, where x is represented by x R mod n for R = 2^(64 k)
+// and k the number of digits of n. Multiplying two such values and
+// dividing by R (Montgomery's REDC) needs no division by n, only
+// multiplications by constants derived from n here, so repeated powmod
+// calls with one modulus build the context once and share it. It is
+// read-only after construction, so several threads may use it at once.
+class MontgomeryContext {
+    public:
+        // throws std::domain_error unless modulus is odd and positive
+        explicit MontgomeryContext(const BigInt& modulus);
+
+        const BigInt& modulus() const;
+
+        // base^exp mod n, in [0, n); throws std::domain_error if exp is
+        // negative
+        BigInt powmod(const BigInt& base, const BigInt& exp) const;
+
+    private:
+        BigInt n;
+        uint64_t n_inv; // -n^-1 mod 2^64
+        DigitVector r2; // R^2 mod n, padded to k digits
+};
+
+// Reduction modulo a fixed positive modulus n, odd or even, by Barrett's
+// method. With mu = floor(b^(2k) / n) precomputed, for k the number of
+// digits of n, the quotient of any x below b^(2k) is estimated within 2
+// by multiplying the top of x by mu, so each reduction takes two
+// multiplications and at most two subtractions of n instead of a long
+// division. Larger inputs are reduced by division. Like
+// MontgomeryContext, it may be shared between threads.
+class BarrettReducer {
+    public:
+        // throws std::domain_error unless modulus is positive
+        explicit BarrettReducer(const BigInt& modulus);
+
+        const BigInt& modulus() const;
+
+        // x mod n, in [0, n) whatever the sign of x
+        BigInt reduce(const BigInt& x) const;
+
+    private:
+        BigInt n;
+        DigitVector mu; // floor(b^(2k) / n)
+};
+
+// A read-only BigInt that doesn't own its digits: a sign and a pointer to
+// normalized digits stored elsewhere, usually a serialized record in a
+// file or network buffer (see BigInt::serialize), or a BigInt. Comparison,
+// addition and multiplication read the digits where they are, so a buffer
+// of records can be worked through without deserializing any of them. A
+// view is only valid while the memory it points into is alive and
+// unchanged.
+class BigIntView {
+    public:
+        // a view of the record at the start of [data, data + size); throws
+        // std::invalid_argument if the bytes aren't a whole, well-formed
+        // record, or if its digits can't be read in place because data
+        // isn't 8-byte aligned or the host isn't little-endian
+        // (BigInt::deserialize copes with both)
+        BigIntView(const unsigned char* data, size_t size);
+
+        // a view of x's digits
+        BigIntView(const BigInt& x);
+
+        bool is_negative() const;
+        size_t size() const; // number of digits
+
+        // the length of the record in bytes, i.e. the offset of the next
+        // one in a buffer of records
+        size_t serialized_size() const;
+
+        BigInt to_bigint() const;
+
+        // -1, 0 or 1 as *this is less than, equal to or greater than rhs
+        int compare(const BigIntView& rhs) const;
+
+        // result = *this + rhs or *this * rhs, in result's existing buffer
+        // if it is large enough; result may be what either view points
+        // into
+        void add_into(const BigIntView& rhs, BigInt& result) const;
+        void multiply_into(const BigIntView& rhs, BigInt& result) const;
+
+    private:
+        const uint64_t* digits;
+        size_t n;
+        bool negative;
+};
+
+// Counts of where BigInt spends its time, kept only when the library is
+// built with BIGINT_STATS defined. It must then be defined for every file
+// that includes BigInt.h, since DigitVector counts its allocations inline;
+// a program that mixes the two settings fails to link. Without it the
+// counting compiles to nothing and every snapshot is zero.
+//
+// Each thread counts into its own block, so counting takes no locks;
+// snapshot() adds up the blocks of every thread, including threads that
+// have exited since the last reset(). Timing reads the clock twice per
+// operation, which is the main cost of counting.
+struct BigIntStats {
+    // The public operations, each counted once per call (or per element
+    // of a batch or file) whichever of these entry points it comes in by:
+    //      ADD          a + b, a += b, add_batch
+    //      SUBTRACT     a - b, a -= b
+    //      MULTIPLY     a * b, a *= b, square, pow, multiply_batch
+    //      DIVIDE       a / b, a % b, a /= b, a %= b, divmod
+    //      FROM_STRING  BigInt(string), operator>>, load_file,
+    //                   for_each_in_file
+    //      TO_STRING    to_string, operator<<, to_string_batch
+    // Other members (powmod, gcd, the roots, BigIntAccumulator, lazy sums,
+    // views, ...) aren't operations of their own; any of the above they
+    // call is counted, as are the algorithms and allocations they use.
+    enum Operation {
+        ADD, SUBTRACT, MULTIPLY, DIVIDE, FROM_STRING, TO_STRING,
+        OPERATION_COUNT
+    };
+
+    // the algorithms chosen for every product and quotient formed
+    // internally, including the recursive ones and those inside division
+    // and radix conversion
+    enum Algorithm {
+        MUL_NATIVE, MUL_BASECASE, SQR_BASECASE, MUL_UNBALANCED,
+        MUL_KARATSUBA, MUL_TOOM32, MUL_TOOM33, MUL_TOOM44, MUL_NTT,
+        DIV_SINGLE, DIV_KNUTH, DIV_BURNIKEL_ZIEGLER, ALGORITHM_COUNT
+    };
+
+    // Operations are also counted by the size of their larger operand in
+    // radix 2^64 digits: bucket i holds sizes of bit length i, i.e. in
+    // [2^(i-1), 2^i), and the last bucket everything longer.
+    static const size_t SIZE_BUCKETS = 32;
+
+#ifdef BIGINT_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    struct OperationStats {
+        uint64_t calls = 0;
+        // time stamp counter cycles on x86-64, nanoseconds elsewhere
+        uint64_t cycles = 0;
+        uint64_t sizes[SIZE_BUCKETS] = {};
+    };
+
+    OperationStats operations[OPERATION_COUNT];
+    uint64_t algorithms[ALGORITHM_COUNT] = {};
+    // digit buffers allocated, and their total size
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+
+    // the counts of every thread since the last reset()
+    static BigIntStats snapshot();
+    static void reset();
+
+    static const char* name(Operation op);
+    static const char* name(Algorithm a);
+
+    // one line per nonzero count, or a JSON object with every count
+    std::string to_text() const;
+    std::string to_json() const;
 };
 
 #endif // BIGINT_H
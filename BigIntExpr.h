@@ -0,0 +1,120 @@
+#ifndef BIGINT_EXPR_H
+#define BIGINT_EXPR_H
+
+// Opt-in expression templates for sums and differences of BigInts.
+//
+// Wrapping the first operand in lazy() makes + and - build a BigIntSum, a
+// fixed-size list of references to the terms and their signs, in place of
+// a temporary BigInt per operator:
+//
+//      BigInt r = lazy(a) + b + c - d;
+//
+// Nothing is computed until the sum is assigned to (or used to construct)
+// a BigInt. Then the whole sum is formed in a single carry sweep over a
+// result sized up front, and assignment reuses the target's buffer. Terms
+// may be temporaries such as products (lazy(a) + b * c), because a
+// BigIntSum is only meant to live until the end of the full expression;
+// don't keep one in a variable (auto e = lazy(a) + b * c), since its
+// references would outlive those temporaries.
+
+#include <cstddef>
+#include "BigInt.h"
+
+template <size_t N>
+class BigIntSum {
+    public:
+        BigIntSum<N + 1> operator+(const BigInt& rhs) const {
+            return append(rhs, false);
+        }
+
+        BigIntSum<N + 1> operator-(const BigInt& rhs) const {
+            return append(rhs, true);
+        }
+
+        template <size_t M>
+        BigIntSum<N + M> operator+(const BigIntSum<M>& rhs) const {
+            return concat(rhs, false);
+        }
+
+        template <size_t M>
+        BigIntSum<N + M> operator-(const BigIntSum<M>& rhs) const {
+            return concat(rhs, true);
+        }
+
+        BigIntSum operator-() const {
+            BigIntSum r = *this;
+            for (size_t i = 0; i < N; ++i) {
+                r.negate[i] = !r.negate[i];
+            }
+            return r;
+        }
+
+    private:
+        const BigInt* terms[N];
+        bool negate[N];
+
+        BigIntSum() { }
+
+        BigIntSum<N + 1> append(const BigInt& x, const bool neg) const {
+            BigIntSum<N + 1> r;
+            for (size_t i = 0; i < N; ++i) {
+                r.terms[i] = terms[i];
+                r.negate[i] = negate[i];
+            }
+            r.terms[N] = &x;
+            r.negate[N] = neg;
+            return r;
+        }
+
+        template <size_t M>
+        BigIntSum<N + M> concat(const BigIntSum<M>& rhs,
+                                const bool neg) const {
+            BigIntSum<N + M> r;
+            for (size_t i = 0; i < N; ++i) {
+                r.terms[i] = terms[i];
+                r.negate[i] = negate[i];
+            }
+            for (size_t i = 0; i < M; ++i) {
+                r.terms[N + i] = rhs.terms[i];
+                r.negate[N + i] = rhs.negate[i] != neg;
+            }
+            return r;
+        }
+
+        template <size_t M> friend class BigIntSum;
+        friend class BigInt;
+        friend BigIntSum<1> lazy(const BigInt& x);
+};
+
+// the start of a lazy sum
+inline BigIntSum<1> lazy(const BigInt& x) {
+    BigIntSum<1> r;
+    r.terms[0] = &x;
+    r.negate[0] = false;
+    return r;
+}
+
+// a lazy sum on the right of a plain BigInt stays lazy
+template <size_t N>
+BigIntSum<N + 1> operator+(const BigInt& lhs, const BigIntSum<N>& rhs) {
+    return lazy(lhs) + rhs;
+}
+
+template <size_t N>
+BigIntSum<N + 1> operator-(const BigInt& lhs, const BigIntSum<N>& rhs) {
+    return lazy(lhs) - rhs;
+}
+
+template <size_t N>
+BigInt::BigInt(const BigIntSum<N>& sum)
+    : BigInt() {
+    assign_sum(sum.terms, sum.negate, N);
+}
+
+template <size_t N>
+BigInt& BigInt::operator=(const BigIntSum<N>& sum) {
+    assign_sum(sum.terms, sum.negate, N);
+    return *this;
+}
+
+#endif // BIGINT_EXPR_H
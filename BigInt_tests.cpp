@@ -1,6 +1,32 @@
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 #include "BigInt.h"
+#include "BigIntExpr.h"
 #include "unit_test_framework.h"
 
+// n nines, i.e. 10^n - 1
+static BigInt nines(const int n) {
+    return BigInt(std::string(n, '9'));
+}
+
+// 10^n
+static BigInt pow10(const int n) {
+    return BigInt("1" + std::string(n, '0'));
+}
+
+// a deterministic n-digit pseudo-random decimal string
+static std::string digit_string(const int n, unsigned seed) {
+    std::string s;
+    for (int i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        s.push_back(char('0' + (seed >> 16) % 10));
+    }
+    s[0] = '7';
+    return s;
+}
+
 TEST(test_default_ctor) {
     BigInt a;
 
@@ -42,6 +68,15 @@ TEST(test_length) {
     ASSERT_EQUAL(a.length(), 5);
     a = "-45678";
     ASSERT_EQUAL(a.length(), 5);
+    ASSERT_EQUAL(BigInt(0).length(), 1);
+
+    // on either side of each power of ten, across the single-digit,
+    // two-digit and general cases
+    for (int k : {1, 2, 18, 19, 20, 38, 39, 40, 100, 1000, 5000}) {
+        ASSERT_EQUAL(nines(k).length(), k);
+        ASSERT_EQUAL(pow10(k).length(), k + 1);
+        ASSERT_EQUAL((-pow10(k)).length(), k + 1);
+    }
 }
 
 TEST(test_addition_no_carry) {
@@ -153,6 +188,139 @@ TEST(test_comparison_opposite_sign) {
     ASSERT_FALSE(a == b);
 }
 
+TEST(test_ctor_leading_zeros) {
+    BigInt a = "000123";
+    ASSERT_EQUAL(a.to_string(), "123");
+    ASSERT_EQUAL(a.length(), 3);
+    a = "-0";
+    ASSERT_EQUAL(a.to_string(), "0");
+    ASSERT_FALSE(a.is_negative());
+}
+
+TEST(test_string_round_trip_multi_digit) {
+    // spans several 64-bit digits and several 19-digit decimal chunks
+    std::string s = "1234567890123456789012345678901234567890"
+                    "9876543210987654321098765432109876543210";
+    BigInt a = s;
+    ASSERT_EQUAL(a.to_string(), s);
+    ASSERT_EQUAL(a.length(), 80);
+    a = "-" + s;
+    ASSERT_EQUAL(a.to_string(), "-" + s);
+
+    a = "10000000000000000000"; // 10^19
+    ASSERT_EQUAL(a.to_string(), "10000000000000000000");
+}
+
+TEST(test_string_round_trip_large) {
+    // long enough for the recursive conversions, which must keep the runs
+    // of zeros between their halves
+    std::string s = digit_string(100000, 14);
+    ASSERT_EQUAL(BigInt(s).to_string(), s);
+    ASSERT_EQUAL(BigInt("-" + s).to_string(), "-" + s);
+
+    s = "1" + std::string(60000, '0') + "1" + std::string(5, '0');
+    BigInt a = s;
+    ASSERT_EQUAL(a.to_string(), s);
+    ASSERT_EQUAL(a.length(), 60007);
+    ASSERT_EQUAL(a - pow10(60006), BigInt(100000));
+}
+
+TEST(test_addition_carry_across_digit) {
+    BigInt a = "18446744073709551615"; // 2^64 - 1
+    BigInt b = "1";
+    BigInt expected = "18446744073709551616";
+    ASSERT_EQUAL(a + b, expected);
+    ASSERT_EQUAL(expected - b, a);
+    ASSERT_EQUAL((a + b) - a, b);
+}
+
+TEST(test_small_values_at_128_bits) {
+    BigInt max128 = "340282366920938463463374607431768211455"; // 2^128 - 1
+    BigInt one = 1;
+    ASSERT_EQUAL(max128 + one,
+                 BigInt("340282366920938463463374607431768211456"));
+    ASSERT_EQUAL(-max128 - one,
+                 BigInt("-340282366920938463463374607431768211456"));
+    ASSERT_EQUAL(one - max128,
+                 BigInt("-340282366920938463463374607431768211454"));
+    ASSERT_EQUAL(max128 + (-max128), BigInt(0));
+    ASSERT_FALSE((max128 + (-max128)).is_negative());
+
+    BigInt a = -7;
+    ASSERT_EQUAL(a * BigInt(6), BigInt(-42));
+    ASSERT_EQUAL(a + BigInt(10), BigInt(3));
+    ASSERT_EQUAL(a - BigInt(-10), BigInt(3));
+    ASSERT_EQUAL(++a, BigInt(-6));
+    ASSERT_EQUAL(a--, BigInt(-6));
+    ASSERT_EQUAL(a, BigInt(-7));
+}
+
+TEST(test_digit_vector_inline_storage) {
+    DigitVector v;
+    ASSERT_TRUE(v.is_inline());
+    v.push_back(1);
+    v.push_back(2);
+    ASSERT_TRUE(v.is_inline());
+    v.push_back(3);
+    ASSERT_FALSE(v.is_inline());
+    ASSERT_EQUAL(v.size(), size_t(3));
+    ASSERT_EQUAL(v[2], uint64_t(3));
+
+    // copies of small vectors stay inline, moves of large ones steal
+    DigitVector w = {4, 5};
+    DigitVector x = w;
+    ASSERT_TRUE(x.is_inline());
+    const uint64_t* heap = v.data();
+    DigitVector y = std::move(v);
+    ASSERT_EQUAL(y.data(), heap);
+    ASSERT_TRUE(v.is_inline());
+    ASSERT_TRUE(v.empty());
+
+    y.swap(x);
+    ASSERT_EQUAL(x.size(), size_t(3));
+    ASSERT_EQUAL(y.size(), size_t(2));
+    ASSERT_EQUAL(y[1], uint64_t(5));
+    ASSERT_TRUE(y.is_inline());
+}
+
+// carries and borrows that run the full length of numbers of every size
+// around the vector kernels' block sizes
+TEST(test_long_carry_chains) {
+    const BigInt base = "18446744073709551616"; // 2^64
+    BigInt power = base;
+    for (int n = 1; n <= 40; ++n) {
+        BigInt all_ones = power - BigInt(1);
+        ASSERT_EQUAL(all_ones + BigInt(1), power);
+        ASSERT_EQUAL(power - all_ones, BigInt(1));
+        ASSERT_TRUE(all_ones < power);
+        ASSERT_TRUE(all_ones + all_ones > all_ones);
+        ASSERT_EQUAL(all_ones + all_ones, power + power - BigInt(2));
+        ASSERT_EQUAL((all_ones + all_ones) - all_ones, all_ones);
+        // equal up to the lowest digit
+        ASSERT_TRUE(all_ones - BigInt(1) < all_ones);
+        ASSERT_FALSE(all_ones < all_ones - BigInt(1));
+        power *= base;
+    }
+}
+
+TEST(test_comparison_multi_digit) {
+    BigInt a = "19";
+    BigInt b = "21";
+    ASSERT_TRUE(a < b);
+    ASSERT_FALSE(b < a);
+
+    a = "-5";
+    b = "-3";
+    ASSERT_TRUE(a < b);
+    ASSERT_FALSE(b < a);
+    ASSERT_TRUE(b > a);
+
+    a = "340282366920938463463374607431768211456"; // 2^128
+    b = "340282366920938463463374607431768211455";
+    ASSERT_TRUE(b < a);
+    ASSERT_TRUE(-a < -b);
+}
+
 TEST(test_mul) {
     BigInt a = "3";
     BigInt b = "2";
@@ -173,4 +341,1052 @@ TEST(test_mul) {
     ASSERT_EQUAL(a * b, expected);
 }
 
+TEST(test_mul_multi_digit) {
+    BigInt a = "18446744073709551615"; // 2^64 - 1
+    BigInt expected = "340282366920938463426481119284349108225";
+    ASSERT_EQUAL(a * a, expected);
+
+    a = "123456789012345678901234567890";
+    BigInt b = "-987654321098765432109876543210";
+    expected = "-121932631137021795226185032733622923332237463801111263526900";
+    ASSERT_EQUAL(a * b, expected);
+
+    BigInt zero;
+    ASSERT_FALSE((b * zero).is_negative());
+}
+
+TEST(test_mul_large_balanced) {
+    // large enough (several hundred digits in radix 2^64) for the
+    // recursive multiplication path
+    for (int n : {700, 3000, 9000}) {
+        BigInt a = nines(n);
+        BigInt expected = pow10(2 * n) - pow10(n) - pow10(n) + BigInt(1);
+        ASSERT_EQUAL(a * a, expected);
+    }
+}
+
+TEST(test_mul_large_unbalanced) {
+    int n = 12000;
+    int m = 1500;
+    BigInt expected = pow10(n + m) - pow10(n) - pow10(m) + BigInt(1);
+    ASSERT_EQUAL(nines(n) * nines(m), expected);
+    ASSERT_EQUAL(nines(m) * nines(n), expected);
+}
+
+TEST(test_mul_toom_cook) {
+    // about 2100 digits in radix 2^64, enough for four-way Toom-Cook
+    int n = 40000;
+    BigInt a = nines(n);
+    BigInt expected = pow10(2 * n) - pow10(n) - pow10(n) + BigInt(1);
+    ASSERT_EQUAL(a * a, expected);
+
+    // operands about 1.6 times as long as each other
+    int m = 25000;
+    expected = pow10(n + m) - pow10(n) - pow10(m) + BigInt(1);
+    ASSERT_EQUAL(nines(n) * nines(m), expected);
+    ASSERT_EQUAL(nines(m) * nines(n), expected);
+
+    BigInt b = digit_string(30000, 4);
+    BigInt c = digit_string(20000, 5);
+    BigInt d = digit_string(12000, 6);
+    ASSERT_EQUAL(b * (c + d), b * c + b * d);
+}
+
+TEST(test_mul_ntt) {
+    // u^4 and u^8 are roughly 8000 and 16000 digits in radix 2^64, past
+    // the transform threshold, and are cheap to build by multiplying
+    BigInt u = digit_string(40000, 7);
+    BigInt u2 = u * u;
+    BigInt u4 = u2 * u2;
+    BigInt one = 1;
+    ASSERT_EQUAL((u4 + one) * (u4 - one), u4 * u4 - one);
+    ASSERT_EQUAL(u4 * u4, (u4 * u2) * u2);
+
+    // a power of two times its predecessor, (2^k - 1) 2^k = 2^2k - 2^k
+    BigInt p = 2;
+    for (int i = 0; i < 19; ++i) {
+        p = p * p;
+    }
+    ASSERT_EQUAL((p - one) * p, p * p - p);
+}
+
+TEST(test_mul_large_distributive) {
+    BigInt a = digit_string(5000, 1);
+    BigInt b = digit_string(4000, 2);
+    BigInt c = -BigInt(digit_string(2500, 3));
+    ASSERT_EQUAL(a * (b + c), a * b + a * c);
+    ASSERT_EQUAL((a * b) * c, a * (b * c));
+}
+
+TEST(test_div_single_digit) {
+    BigInt a = "123";
+    BigInt b = "9";
+    ASSERT_EQUAL(a / b, BigInt("13"));
+
+    a = "340282366920938463463374607431768211456"; // 2^128
+    b = "3";
+    ASSERT_EQUAL(a / b, BigInt("113427455640312821154458202477256070485"));
+}
+
+TEST(test_div_multi_digit) {
+    BigInt a = "121932631137021795226185032733622923332237463801111263526900";
+    BigInt b = "987654321098765432109876543210";
+    ASSERT_EQUAL(a / b, BigInt("123456789012345678901234567890"));
+    ASSERT_EQUAL(a % b, BigInt(0));
+
+    a = a + BigInt(12345);
+    ASSERT_EQUAL(a / b, BigInt("123456789012345678901234567890"));
+    ASSERT_EQUAL(a % b, BigInt(12345));
+
+    // a smaller dividend
+    ASSERT_EQUAL(b / a, BigInt(0));
+    ASSERT_EQUAL(b % a, b);
+}
+
+TEST(test_div_add_back) {
+    // the first estimated quotient digit here is one too large even after
+    // the two-digit correction, exercising the add-back step
+    BigInt a = "12554203470773361527671578846415332832177040772817504698367";
+    BigInt b = "3138550867693340381917894711603833208051177722232017256447";
+    ASSERT_EQUAL(a / b, BigInt(3));
+    ASSERT_EQUAL(a % b,
+        BigInt("3138550867693340381917894711603833208023507606121452929026"));
+}
+
+TEST(test_div_signs) {
+    // truncation toward zero, remainder with the dividend's sign
+    BigInt a = "100000000000000000000000000007";
+    BigInt b = "10000000000000000000000000000";
+    ASSERT_EQUAL(a / b, BigInt(10));
+    ASSERT_EQUAL(a % b, BigInt(7));
+    ASSERT_EQUAL(-a / b, BigInt(-10));
+    ASSERT_EQUAL(-a % b, BigInt(-7));
+    ASSERT_EQUAL(a / -b, BigInt(-10));
+    ASSERT_EQUAL(a % -b, BigInt(7));
+    ASSERT_EQUAL(-a / -b, BigInt(10));
+    ASSERT_EQUAL(-a % -b, BigInt(-7));
+    ASSERT_FALSE((-b % b).is_negative());
+}
+
+TEST(test_divmod) {
+    BigInt a = digit_string(3000, 8);
+    BigInt b = digit_string(1100, 9);
+    BigInt q, r;
+    BigInt::divmod(a, b, q, r);
+    ASSERT_EQUAL(q * b + r, a);
+    ASSERT_TRUE(r < b);
+    ASSERT_FALSE(r.is_negative());
+
+    // outputs may alias the inputs
+    BigInt::divmod(a, b, a, b);
+    ASSERT_EQUAL(a, q);
+    ASSERT_EQUAL(b, r);
+}
+
+TEST(test_div_large) {
+    // past the recursive division threshold in both divisor and quotient
+    BigInt x = digit_string(20000, 10);
+    BigInt y = digit_string(12000, 11);
+    ASSERT_EQUAL((x * y) / y, x);
+    ASSERT_EQUAL((x * y) % y, BigInt(0));
+
+    BigInt rem = digit_string(11000, 13);
+    BigInt a = x * y + rem;
+    BigInt q, r;
+    BigInt::divmod(a, y, q, r);
+    ASSERT_EQUAL(q, x);
+    ASSERT_EQUAL(r, rem);
+
+    // an unbalanced division, many blocks of the divisor long
+    BigInt z = digit_string(4000, 12);
+    BigInt::divmod(a, z, q, r);
+    ASSERT_EQUAL(q * z + r, a);
+    ASSERT_TRUE(r < z);
+    ASSERT_FALSE(r.is_negative());
+}
+
+TEST(test_div_assign) {
+    BigInt a = "1000000000000000000000000000000";
+    a /= BigInt("1000000000000000");
+    ASSERT_EQUAL(a, BigInt("1000000000000000"));
+    a %= BigInt(999);
+    ASSERT_EQUAL(a, BigInt("1000000000000000") % BigInt(999));
+}
+
+TEST(test_div_by_zero) {
+    BigInt a = "12345";
+    bool thrown = false;
+    try {
+        a / BigInt(0);
+    }
+    catch (const std::domain_error&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+}
+
+// a memory resource that counts the allocations made from it and the
+// bytes outstanding
+class CountingResource : public std::pmr::memory_resource {
+    public:
+        long allocations = 0;
+        long outstanding = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t align) override {
+            ++allocations;
+            outstanding += long(bytes);
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            outstanding -= long(bytes);
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other)
+                const noexcept override {
+            return this == &other;
+        }
+};
+
+TEST(test_memory_resource) {
+    CountingResource counter;
+    std::pmr::memory_resource* previous =
+        BigInt::set_memory_resource(&counter);
+    ASSERT_EQUAL(BigInt::memory_resource(), &counter);
+    {
+        BigInt a = digit_string(200, 1);
+        BigInt b = a * a;
+        ASSERT_TRUE(counter.outstanding > 0);
+        BigInt::set_memory_resource(previous);
+        ASSERT_EQUAL(b / a, a);
+    }
+    ASSERT_EQUAL(counter.outstanding, 0L);
+    ASSERT_EQUAL(BigInt::memory_resource(), previous);
+}
+
+TEST(test_arena) {
+    std::pmr::memory_resource* outside = BigInt::memory_resource();
+    BigInt kept;
+    BigInt expected = pow10(3000) - BigInt(1);
+    {
+        BigIntArena arena;
+        ASSERT_EQUAL(BigInt::memory_resource(), arena.resource());
+        BigInt x = pow10(1500);
+        BigInt y = x * x - BigInt(1);
+        kept = std::move(y); // copied out of the arena
+        {
+            BigIntArena inner(1024);
+            ASSERT_EQUAL(BigInt::memory_resource(), inner.resource());
+            ASSERT_EQUAL((x * x) / x, x);
+        }
+        ASSERT_EQUAL(BigInt::memory_resource(), arena.resource());
+    }
+    ASSERT_EQUAL(BigInt::memory_resource(), outside);
+    ASSERT_EQUAL(kept, expected);
+
+    // one arena reused across batches
+    BigIntArena arena;
+    for (int batch = 0; batch < 3; ++batch) {
+        {
+            BigInt a = digit_string(500, batch);
+            ASSERT_EQUAL((a * a) % a, BigInt(0));
+        }
+        arena.release();
+    }
+}
+
+TEST(test_compound_assignment) {
+    BigInt x = digit_string(300, 3);
+    BigInt y = digit_string(200, 4);
+    BigInt sum = x + y;
+    BigInt diff = x - y;
+
+    BigInt a = x;
+    a += y;
+    ASSERT_EQUAL(a, sum);
+    a -= y;
+    ASSERT_EQUAL(a, x);
+    a -= x + y; // crosses zero
+    ASSERT_EQUAL(a, -y);
+    a += y;
+    ASSERT_EQUAL(a, BigInt(0));
+    ASSERT_FALSE(a.is_negative());
+
+    a = y;
+    a -= x;
+    ASSERT_EQUAL(a, -diff);
+    a = -y;
+    a += x;
+    ASSERT_EQUAL(a, diff);
+
+    // operands aliasing the target
+    a = x;
+    a += a;
+    ASSERT_EQUAL(a, x * BigInt(2));
+    a -= a;
+    ASSERT_EQUAL(a, BigInt(0));
+    ASSERT_FALSE(a.is_negative());
+
+    a = -x;
+    a *= BigInt(-3);
+    ASSERT_EQUAL(a, x + x + x);
+    a *= BigInt(0);
+    ASSERT_EQUAL(a, BigInt(0));
+    ASSERT_FALSE(a.is_negative());
+    a = BigInt(-5);
+    a *= y;
+    ASSERT_EQUAL(a, -(y * BigInt(5)));
+    a = -x;
+    a *= a;
+    ASSERT_EQUAL(a, x * x);
+}
+
+TEST(test_rvalue_operands) {
+    BigInt x = digit_string(300, 5);
+    BigInt y = digit_string(250, 6);
+    BigInt sum = x + y;
+    BigInt diff = x - y;
+
+    ASSERT_EQUAL(BigInt(x) + y, sum);
+    ASSERT_EQUAL(x + BigInt(y), sum);
+    ASSERT_EQUAL(BigInt(x) + BigInt(y), sum);
+    ASSERT_EQUAL(BigInt(x) - y, diff);
+    ASSERT_EQUAL(x - BigInt(y), diff);
+    ASSERT_EQUAL(y - BigInt(x), -diff);
+    ASSERT_EQUAL(BigInt(x) - BigInt(y), diff);
+    ASSERT_EQUAL(-BigInt(x) - BigInt(y), -sum);
+    ASSERT_EQUAL(x - BigInt(x), BigInt(0));
+    ASSERT_FALSE((x - BigInt(x)).is_negative());
+    ASSERT_EQUAL(BigInt(5) - BigInt(0), BigInt(5));
+    ASSERT_EQUAL(BigInt(0) - BigInt(0), BigInt(0));
+    ASSERT_FALSE((BigInt(3) - BigInt(0)).is_negative());
+    ASSERT_FALSE((-BigInt(0)).is_negative());
+
+    BigInt t = x;
+    BigInt u = std::move(t) + y;
+    ASSERT_EQUAL(u, sum);
+}
+
+TEST(test_accumulate_without_allocating) {
+    std::vector<BigInt> values;
+    for (int i = 0; i < 1000; ++i) {
+        BigInt v = digit_string(40, i);
+        values.push_back(i % 3 ? v : -v);
+    }
+
+    CountingResource counter;
+    std::pmr::memory_resource* previous =
+        BigInt::set_memory_resource(&counter);
+    BigInt acc;
+    for (int round = 0; round < 100; ++round) {
+        for (const BigInt& v : values) {
+            acc += v;
+        }
+        if (round == 0) {
+            counter.allocations = 0; // warmed up
+        }
+    }
+    long allocations = counter.allocations;
+    BigInt::set_memory_resource(previous);
+
+    BigInt expected;
+    for (const BigInt& v : values) {
+        expected = expected + v;
+    }
+    ASSERT_EQUAL(acc, expected * BigInt(100));
+    ASSERT_TRUE(allocations <= 2);
+}
+
+TEST(test_lazy_sum) {
+    BigInt a = digit_string(400, 7);
+    BigInt b = digit_string(300, 8);
+    BigInt c = -BigInt(digit_string(350, 9));
+    BigInt d = digit_string(20, 10);
+
+    BigInt r = lazy(a) + b + c - d;
+    ASSERT_EQUAL(r, a + b + c - d);
+    r = lazy(d) - a - b;
+    ASSERT_EQUAL(r, d - a - b);
+    ASSERT_TRUE(r.is_negative());
+    r = lazy(a) - a;
+    ASSERT_EQUAL(r, BigInt(0));
+    ASSERT_FALSE(r.is_negative());
+
+    // temporaries as terms, sums of sums, and sums on the right
+    r = lazy(a) + b * d - c;
+    ASSERT_EQUAL(r, a + b * d - c);
+    r = (lazy(a) - b) - (lazy(c) - d);
+    ASSERT_EQUAL(r, a - b - c + d);
+    r = a - (lazy(b) + c);
+    ASSERT_EQUAL(r, a - b - c);
+    r = -(lazy(a) + b);
+    ASSERT_EQUAL(r, -(a + b));
+
+    // the target as a term
+    BigInt t = b;
+    t = lazy(t) + t + a;
+    ASSERT_EQUAL(t, b + b + a);
+    t = lazy(c) - t;
+    ASSERT_EQUAL(t, c - b - b - a);
+
+    // carries and borrows across the whole width
+    BigInt max128 = "340282366920938463463374607431768211455";
+    ASSERT_EQUAL(BigInt(lazy(max128) + max128 + BigInt(2)),
+                 max128 * BigInt(2) + BigInt(2));
+    ASSERT_EQUAL(BigInt(lazy(BigInt(1)) - max128 - BigInt(1)), -max128);
+}
+
+TEST(test_sum) {
+    std::vector<BigInt> values;
+    BigInt expected;
+    for (int i = 0; i < 100; ++i) {
+        BigInt v = digit_string(50, i);
+        values.push_back(v);
+        expected += v;
+    }
+    ASSERT_EQUAL(BigInt::sum(values.begin(), values.end()), expected);
+    ASSERT_EQUAL(BigInt::sum(values.begin(), values.begin()), BigInt(0));
+
+    // all-ones digits produce a carry out of every column
+    BigInt max128 = "340282366920938463463374607431768211455";
+    std::vector<BigInt> ones(1000, max128);
+    ASSERT_EQUAL(BigInt::sum(ones.begin(), ones.end()),
+                 max128 * BigInt(1000));
+}
+
+TEST(test_accumulator) {
+    BigIntAccumulator acc;
+    ASSERT_EQUAL(acc.total(), BigInt(0));
+
+    BigInt expected;
+    for (int i = 0; i < 300; ++i) {
+        // mixed lengths and signs
+        BigInt v = digit_string(1 + (i * 37) % 400, i);
+        if (i % 3 == 0) {
+            acc -= v;
+            expected -= v;
+        }
+        else if (i % 3 == 1) {
+            acc += -v;
+            expected -= v;
+        }
+        else {
+            acc += v;
+            expected += v;
+        }
+    }
+    ASSERT_EQUAL(acc.total(), expected);
+    ASSERT_EQUAL(acc.total(), expected); // total() doesn't disturb the sum
+
+    acc += -expected;
+    ASSERT_EQUAL(acc.total(), BigInt(0));
+    ASSERT_FALSE(acc.total().is_negative());
+
+    acc.clear();
+    acc -= BigInt(1);
+    ASSERT_EQUAL(acc.total(), BigInt(-1));
+}
+
+TEST(test_threads) {
+    ASSERT_EQUAL(BigInt::threads(), 1u);
+    const size_t threshold = BigInt::parallel_threshold();
+
+    // Karatsuba, Toom-3 (balanced and not), Toom-4 and NTT sizes
+    const int lengths[][2] = {{2000, 1500}, {20000, 19000}, {30000, 18000},
+                              {40000, 40000}, {150000, 140000}};
+    std::vector<BigInt> a, b, expected;
+    for (const auto& len : lengths) {
+        a.push_back(digit_string(len[0], len[0]));
+        b.push_back(-BigInt(digit_string(len[1], len[1] + 1)));
+        expected.push_back(a.back() * b.back());
+    }
+
+    BigInt::set_threads(4);
+    BigInt::set_parallel_threshold(32); // split at every level
+    ASSERT_EQUAL(BigInt::threads(), 4u);
+    for (size_t i = 0; i < a.size(); ++i) {
+        ASSERT_EQUAL(a[i] * b[i], expected[i]);
+    }
+    {
+        // the calling thread's temporaries come from its arena
+        BigIntArena arena;
+        ASSERT_EQUAL(a[3] * b[3], expected[3]);
+    }
+
+    BigInt::set_threads(1);
+    BigInt::set_parallel_threshold(threshold);
+    ASSERT_EQUAL(BigInt::threads(), 1u);
+    ASSERT_EQUAL(a[1] * b[1], expected[1]);
+}
+
+TEST(test_batch) {
+    // mixed sizes and signs, with one pair big enough to split further
+    const size_t n = 200;
+    std::vector<BigInt> a, b;
+    for (size_t i = 0; i < n; ++i) {
+        BigInt x = digit_string(1 + int(i * 53 % 900), int(i));
+        BigInt y = digit_string(1 + int(i * 31 % 700), int(i + n));
+        a.push_back(i % 3 == 0 ? -x : x);
+        b.push_back(i % 5 == 0 ? -y : y);
+    }
+    a[7] = digit_string(30000, 1);
+    b[7] = digit_string(25000, 2);
+
+    for (unsigned threads : {1u, 4u}) {
+        BigInt::set_threads(threads);
+        std::vector<BigInt> prod(n), sum(n);
+        std::vector<std::string> str(n);
+        BigInt::multiply_batch(a.data(), b.data(), prod.data(), n);
+        BigInt::add_batch(a.data(), b.data(), sum.data(), n);
+        BigInt::to_string_batch(prod.data(), str.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQUAL(prod[i], a[i] * b[i]);
+            ASSERT_EQUAL(sum[i], a[i] + b[i]);
+            ASSERT_EQUAL(str[i], prod[i].to_string());
+        }
+
+        // in place, with outputs from the caller's arena
+        BigIntArena arena;
+        std::vector<BigInt> c(a.begin(), a.end());
+        BigInt::multiply_batch(c.data(), b.data(), c.data(), n);
+        BigInt::add_batch(b.data(), c.data(), c.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQUAL(c[i], a[i] * b[i] + b[i]);
+        }
+    }
+    BigInt::set_threads(1);
+    BigInt::multiply_batch(a.data(), b.data(), nullptr, 0);
+}
+
+TEST(test_powmod) {
+    // small cases against repeated multiplication
+    for (int m : {1, 2, 3, 10, 97, 1000, 65537}) {
+        for (int a : {-13, 0, 1, 2, 5, 123456}) {
+            BigInt expected = BigInt(1) % BigInt(m);
+            for (int e = 0; e < 40; ++e) {
+                ASSERT_EQUAL(BigInt::powmod(a, e, m), expected);
+                expected = (expected * BigInt(a)) % BigInt(m);
+                if (expected.is_negative()) {
+                    expected += BigInt(m);
+                }
+            }
+        }
+    }
+
+    // Fermat's little theorem for the prime 2^127 - 1
+    BigInt p("170141183460469231731687303715884105727");
+    MontgomeryContext ctx(p);
+    ASSERT_EQUAL(ctx.modulus(), p);
+    for (int a : {2, 3, 1234567}) {
+        ASSERT_EQUAL(ctx.powmod(a, p - BigInt(1)), BigInt(1));
+        ASSERT_EQUAL(ctx.powmod(a, p), BigInt(a));
+    }
+
+    // a^(e + f) = a^e a^f with 2048-bit values, odd and even moduli
+    BigInt a = digit_string(650, 1);
+    BigInt e = digit_string(617, 2);
+    BigInt f = digit_string(300, 3);
+    for (BigInt m : {BigInt(digit_string(617, 4)) * BigInt(2) + BigInt(1),
+                     BigInt(digit_string(617, 5)) * BigInt(2)}) {
+        BigInt lhs = BigInt::powmod(a, e + f, m);
+        BigInt rhs = (BigInt::powmod(a, e, m) * BigInt::powmod(a, f, m)) % m;
+        ASSERT_EQUAL(lhs, rhs);
+        ASSERT_TRUE(lhs < m && !lhs.is_negative());
+    }
+
+    for (int m : {0, -7}) {
+        bool threw = false;
+        try {
+            BigInt::powmod(2, 3, m);
+        }
+        catch (const std::domain_error&) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+    }
+    bool threw = false;
+    try {
+        BigInt::powmod(2, -1, 7);
+    }
+    catch (const std::domain_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    threw = false;
+    try {
+        MontgomeryContext even(10);
+    }
+    catch (const std::domain_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(test_barrett) {
+    // odd and even moduli, from one digit to past the short product sizes
+    for (int len : {1, 19, 20, 40, 300, 700, 2500}) {
+        BigInt m = digit_string(len, len);
+        BarrettReducer reducer(m);
+        ASSERT_EQUAL(reducer.modulus(), m);
+        BigInt m2 = m * m;
+        for (const BigInt& x : {BigInt(0), BigInt(1), m - BigInt(1), m,
+                                m + BigInt(1), m2 - BigInt(1), m2,
+                                BigInt(digit_string(2 * len, 7)),
+                                -BigInt(digit_string(2 * len - 1, 8)),
+                                BigInt(digit_string(3 * len, 9)) * m}) {
+            BigInt expected = x % m;
+            if (expected.is_negative()) {
+                expected += m;
+            }
+            ASSERT_EQUAL(reducer.reduce(x), expected);
+        }
+    }
+    ASSERT_EQUAL(BarrettReducer(1).reduce(12345), BigInt(0));
+
+    bool threw = false;
+    try {
+        BarrettReducer zero(0);
+    }
+    catch (const std::domain_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(test_gcd) {
+    ASSERT_EQUAL(BigInt::gcd(0, 0), BigInt(0));
+    ASSERT_EQUAL(BigInt::gcd(0, -5), BigInt(5));
+    ASSERT_EQUAL(BigInt::gcd(12, 18), BigInt(6));
+    ASSERT_EQUAL(BigInt::gcd(-12, 18), BigInt(6));
+    ASSERT_EQUAL(BigInt::gcd(17, -5), BigInt(1));
+
+    // gcd(F_m, F_n) = F_gcd(m, n) for Fibonacci numbers, whose quotients
+    // are all 1, from Lehmer sizes up into the half-gcd
+    std::vector<BigInt> fib = {0, 1};
+    while (fib.size() <= 60000) {
+        fib.push_back(fib[fib.size() - 1] + fib[fib.size() - 2]);
+    }
+    ASSERT_EQUAL(BigInt::gcd(fib[3000], fib[3001]), BigInt(1));
+    ASSERT_EQUAL(BigInt::gcd(fib[4500], fib[3000]), fib[1500]);
+    ASSERT_EQUAL(BigInt::gcd(fib[60000], fib[45000]), fib[15000]);
+
+    // common factors of random numbers of very different lengths
+    for (int len : {30, 400, 3000, 20000}) {
+        BigInt g = digit_string(len / 3 + 1, len);
+        BigInt a = digit_string(len, len + 1);
+        BigInt b = digit_string(len / 2 + 1, len + 2);
+        BigInt d = BigInt::gcd(a, b);
+        ASSERT_EQUAL(BigInt::gcd(a * g, -(b * g)), d * g);
+
+        BigInt x, y;
+        ASSERT_EQUAL(BigInt::extended_gcd(a * g, b * g, x, y), d * g);
+        ASSERT_EQUAL(a * g * x + b * g * y, d * g);
+        ASSERT_EQUAL(BigInt::extended_gcd(-a, b, x, y), d);
+        ASSERT_EQUAL(-a * x + b * y, d);
+    }
+
+    BigInt x, y;
+    ASSERT_EQUAL(BigInt::extended_gcd(0, -7, x, y), BigInt(7));
+    ASSERT_EQUAL(x * BigInt(0) + y * BigInt(-7), BigInt(7));
+    ASSERT_EQUAL(BigInt::extended_gcd(fib[2001], fib[2000], x, y), BigInt(1));
+    ASSERT_EQUAL(fib[2001] * x + fib[2000] * y, BigInt(1));
+}
+
+TEST(test_modinv) {
+    ASSERT_EQUAL(BigInt::modinv(3, 7), BigInt(5));
+    ASSERT_EQUAL(BigInt::modinv(-3, 7), BigInt(2));
+    ASSERT_EQUAL(BigInt::modinv(10, 1), BigInt(0));
+
+    BigInt p("170141183460469231731687303715884105727"); // 2^127 - 1
+    for (const BigInt& a : {BigInt(2), BigInt(digit_string(30, 1)),
+                            -BigInt(digit_string(100, 2))}) {
+        BigInt inv = BigInt::modinv(a, p);
+        ASSERT_TRUE(!inv.is_negative() && inv < p);
+        BigInt r = (a * inv) % p;
+        ASSERT_TRUE(r == BigInt(1) || r == BigInt(1) - p);
+    }
+    // a and a b + 1 are coprime
+    BigInt a = digit_string(4000, 4);
+    BigInt m = a * BigInt(digit_string(1000, 5)) + BigInt(1);
+    ASSERT_EQUAL((a * BigInt::modinv(a, m)) % m, BigInt(1));
+
+    for (int mod : {0, -7, 6}) {
+        bool threw = false;
+        try {
+            BigInt::modinv(4, mod);
+        }
+        catch (const std::domain_error&) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+    }
+}
+
+TEST(test_square_pow) {
+    // each multiplication tier squares when handed one operand twice; a
+    // copy has its own digits, so multiplying by it takes the general path
+    for (int n : {1, 19, 40, 700, 1000, 8000, 40000}) {
+        BigInt a = digit_string(n, unsigned(n));
+        BigInt copy = a;
+        ASSERT_EQUAL(a.square(), a * copy);
+        ASSERT_EQUAL((-a).square(), a * copy);
+        BigInt b = a;
+        b *= b;
+        ASSERT_EQUAL(b, a * copy);
+    }
+    BigInt u = digit_string(40000, 7);
+    BigInt u4 = u.square().square();
+    BigInt u4_copy = u4;
+    ASSERT_EQUAL(u4.square(), u4 * u4_copy);
+
+    ASSERT_EQUAL(BigInt::pow(0, 0), BigInt(1));
+    ASSERT_EQUAL(BigInt::pow(-5, 0), BigInt(1));
+    ASSERT_EQUAL(BigInt::pow(0, 7), BigInt(0));
+    ASSERT_EQUAL(BigInt::pow(-1, 1001), BigInt(-1));
+    ASSERT_EQUAL(BigInt::pow(-2, 63), BigInt("-9223372036854775808"));
+    ASSERT_EQUAL(BigInt::pow(-2, 64), BigInt("18446744073709551616"));
+    ASSERT_EQUAL(BigInt::pow(10, 5000), BigInt("1" + std::string(5000, '0')));
+
+    BigInt three = 3;
+    BigInt expected = 1;
+    for (int i = 0; i < 3000; ++i) {
+        expected *= three;
+    }
+    ASSERT_EQUAL(BigInt::pow(three, 3000), expected);
+
+    BigInt a = -BigInt(digit_string(300, 8));
+    BigInt copy = a;
+    ASSERT_EQUAL(BigInt::pow(a, 5), a * copy * a * copy * a);
+}
+
+TEST(test_roots) {
+    BigInt rem;
+    ASSERT_EQUAL(BigInt::isqrt(0), BigInt(0));
+    ASSERT_EQUAL(BigInt::isqrt_rem(99, rem), BigInt(9));
+    ASSERT_EQUAL(rem, BigInt(18));
+    BigInt max128("340282366920938463463374607431768211455"); // 2^128 - 1
+    ASSERT_EQUAL(BigInt::isqrt_rem(max128, rem),
+                 BigInt("18446744073709551615"));
+    ASSERT_EQUAL(rem, BigInt("36893488147419103230"));
+    ASSERT_EQUAL(BigInt::iroot(26, 3), BigInt(2));
+    ASSERT_EQUAL(BigInt::iroot(27, 3), BigInt(3));
+    ASSERT_EQUAL(BigInt::iroot(-30, 3), BigInt(-3));
+    ASSERT_EQUAL(BigInt::iroot(12345, 1), BigInt(12345));
+    ASSERT_EQUAL(BigInt::iroot(BigInt::pow(10, 1000), 1000), BigInt(10));
+
+    // s = isqrt(n) and r = n - s^2 exactly when 0 <= r <= 2s
+    for (int n : {30, 1000, 20000}) {
+        BigInt a = digit_string(n, unsigned(n));
+        BigInt s = BigInt::isqrt_rem(a, rem);
+        ASSERT_EQUAL(s * s + rem, a);
+        ASSERT_TRUE(!rem.is_negative() && rem <= s + s);
+        ASSERT_EQUAL(BigInt::isqrt(s * s), s);
+        ASSERT_EQUAL(BigInt::isqrt(s * s - BigInt(1)), s - BigInt(1));
+    }
+    // and r = iroot(n, k) when r^k <= n < (r + 1)^k
+    for (unsigned k : {3u, 5u, 17u, 300u}) {
+        BigInt a = digit_string(5000, k);
+        BigInt r = BigInt::iroot(a, k);
+        ASSERT_TRUE(BigInt::pow(r, k) <= a);
+        ASSERT_TRUE(BigInt::pow(r + BigInt(1), k) > a);
+        BigInt p = BigInt::pow(r, k);
+        ASSERT_EQUAL(BigInt::iroot(p, k), r);
+        ASSERT_EQUAL(BigInt::iroot(p - BigInt(1), k), r - BigInt(1));
+    }
+
+    bool threw = false;
+    try {
+        BigInt::isqrt(-1);
+    }
+    catch (const std::domain_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    for (unsigned k : {0u, 4u}) {
+        threw = false;
+        try {
+            BigInt::iroot(-8, k);
+        }
+        catch (const std::domain_error&) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+    }
+}
+
+TEST(test_serialize) {
+    std::vector<BigInt> values = {BigInt(0), BigInt(-1),
+                                  BigInt("18446744073709551616"),
+                                  BigInt(digit_string(3000, 1)),
+                                  -BigInt(digit_string(500, 2))};
+    std::vector<unsigned char> buffer;
+    for (const BigInt& x : values) {
+        x.serialize(buffer);
+    }
+    ASSERT_EQUAL(values[2].serialized_size(), size_t(32));
+
+    // walk the records both by copying and in place
+    size_t pos = 0;
+    for (const BigInt& x : values) {
+        size_t used = 0;
+        BigInt y = BigInt::deserialize(buffer.data() + pos,
+                                       buffer.size() - pos, &used);
+        ASSERT_EQUAL(y, x);
+        BigIntView v(buffer.data() + pos, buffer.size() - pos);
+        ASSERT_EQUAL(v.serialized_size(), used);
+        ASSERT_EQUAL(v.is_negative(), x.is_negative());
+        ASSERT_EQUAL(v.to_bigint(), x);
+        pos += used;
+    }
+    ASSERT_EQUAL(pos, buffer.size());
+
+    // arithmetic on views of records and of BigInts
+    const size_t at3 = values[0].serialized_size() +
+                       values[1].serialized_size() +
+                       values[2].serialized_size();
+    BigIntView big(buffer.data() + at3, buffer.size() - at3);
+    BigInt a = values[3], b = values[4], r = 7;
+    big.add_into(b, r);
+    ASSERT_EQUAL(r, a + b);
+    BigIntView(b).add_into(r, r);
+    ASSERT_EQUAL(r, a + b + b);
+    BigIntView(r).add_into(-a, r);
+    ASSERT_EQUAL(r, b + b);
+    BigIntView(b).multiply_into(big, r);
+    ASSERT_EQUAL(r, a * b);
+    BigIntView(r).add_into(r, r);
+    ASSERT_EQUAL(r, (a * b) + (a * b));
+    BigIntView(b).add_into(-b, r);
+    ASSERT_EQUAL(r, BigInt(0));
+    ASSERT_FALSE(r.is_negative());
+    ASSERT_EQUAL(big.compare(a), 0);
+    ASSERT_EQUAL(big.compare(b), 1);
+    ASSERT_EQUAL(BigIntView(b).compare(-a), 1);
+    ASSERT_EQUAL(BigIntView(b).compare(b - BigInt(1)), 1);
+
+    // truncated, an unknown version, a leading zero digit, negative zero
+    std::vector<unsigned char> bad(buffer.begin(), buffer.begin() + 16);
+    std::vector<std::vector<unsigned char>> malformed(4, bad);
+    malformed[0].pop_back();
+    malformed[1][0] = 2;
+    malformed[2][8] = 2;
+    malformed[2].resize(32, 0);
+    malformed[2][16] = 1;
+    malformed[3][1] = 1;
+    for (const auto& m : malformed) {
+        bool threw = false;
+        try {
+            BigInt::deserialize(m.data(), m.size());
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        ASSERT_TRUE(threw);
+    }
+}
+
+TEST(test_load_file) {
+    // enough lines for several segments, with a blank line, "\r\n" line
+    // ends, negatives, and one long line
+    std::vector<BigInt> expected;
+    std::string text;
+    for (int i = 0; i < 30000; ++i) {
+        std::string line = digit_string(1 + i % 60, unsigned(i));
+        if (i % 7 == 0) {
+            line = "-" + line;
+        }
+        if (i == 12345) {
+            line = digit_string(5000, 3);
+        }
+        expected.push_back(BigInt(line));
+        text += line + (i % 2 ? "\r\n" : "\n");
+        if (i == 100) {
+            text += "\n";
+        }
+    }
+    expected.push_back(BigInt(0));
+    text += "-0"; // no final newline
+    const std::string path = "test_load_file.tmp";
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    ASSERT_TRUE(out != nullptr);
+    std::fwrite(text.data(), 1, text.size(), out);
+    std::fclose(out);
+
+    BigInt total;
+    for (const BigInt& x : expected) {
+        total += x;
+    }
+    for (unsigned threads : {1u, 4u}) {
+        BigInt::set_threads(threads);
+        std::vector<BigInt> values = BigInt::load_file(path);
+        ASSERT_EQUAL(values.size(), expected.size());
+        ASSERT_TRUE(values == expected);
+        BigInt sum;
+        BigInt::for_each_in_file(path, [&](BigInt& x) { sum += x; });
+        ASSERT_EQUAL(sum, total);
+    }
+    BigInt::set_threads(1);
+
+    out = std::fopen(path.c_str(), "wb");
+    std::fputs("12\n-\n", out);
+    std::fclose(out);
+    bool threw = false;
+    try {
+        BigInt::load_file(path);
+    }
+    catch (const std::invalid_argument& e) {
+        threw = std::string(e.what()).find("line 2") != std::string::npos;
+    }
+    ASSERT_TRUE(threw);
+
+    // two bad lines in different segments: whichever segment is parsed
+    // first, the earlier line is reported, after the lines before it
+    BigInt::set_threads(4);
+    text.clear();
+    for (int i = 1; i <= 40000; ++i) {
+        text += i == 1000 || i == 35000 ? "x\n" : digit_string(19, 7) + "\n";
+    }
+    out = std::fopen(path.c_str(), "wb");
+    std::fwrite(text.data(), 1, text.size(), out);
+    std::fclose(out);
+    for (int repeat = 0; repeat < 10; ++repeat) {
+        size_t seen = 0;
+        std::string what;
+        try {
+            BigInt::for_each_in_file(path, [&](BigInt&) { ++seen; });
+        }
+        catch (const std::invalid_argument& e) {
+            what = e.what();
+        }
+        ASSERT_TRUE(what.find("line 1000 ") != std::string::npos);
+        ASSERT_EQUAL(seen, size_t(999));
+    }
+    BigInt::set_threads(1);
+    std::remove(path.c_str());
+
+    threw = false;
+    try {
+        BigInt::load_file(path);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+TEST(test_stream_io) {
+    const BigInt big(digit_string(3000, 5));
+    const BigInt x("-18446744073709551616");
+    std::ostringstream out;
+    out << x << ' ' << std::hex << x << ' ' << std::showbase
+        << std::uppercase << BigInt(255) << ' ' << std::oct << BigInt(8)
+        << ' ' << BigInt(0) << std::dec << std::noshowbase
+        << std::nouppercase << ' ' << std::showpos << BigInt(0) << ' '
+        << std::setw(6) << BigInt(42) << ' ' << std::noshowpos
+        << std::left << std::setfill('*') << std::setw(4) << BigInt(-7)
+        << ' ' << std::internal << std::setw(5) << BigInt(-7) << ' '
+        << big;
+    ASSERT_EQUAL(out.str(), "-18446744073709551616 -10000000000000000 "
+                            "0XFF 010 0 +0    +42 -7** -***7 " +
+                            big.to_string());
+
+    // values longer than a block of input, leading zeros, and other bases
+    std::istringstream in("  " + big.to_string() + " -0007 +12x 0x1f "
+                          "-Ab 17 - 5");
+    BigInt a, b, c, d, e, f;
+    in >> a >> b >> c;
+    ASSERT_EQUAL(a, big);
+    ASSERT_EQUAL(b, BigInt(-7));
+    ASSERT_EQUAL(c, BigInt(12));
+    ASSERT_EQUAL(char(in.get()), 'x');
+    in >> std::hex >> d >> e >> std::oct >> f >> std::dec;
+    ASSERT_EQUAL(d, BigInt(31));
+    ASSERT_EQUAL(e, BigInt(-171));
+    ASSERT_EQUAL(f, BigInt(15));
+    ASSERT_TRUE(in.good());
+    in >> a;
+    ASSERT_TRUE(in.fail());
+    ASSERT_EQUAL(a, BigInt(0));
+
+    std::ostringstream hex_out;
+    hex_out << std::hex << -big;
+    std::istringstream hex_in(hex_out.str());
+    hex_in >> std::hex >> a;
+    ASSERT_EQUAL(a, -big);
+    ASSERT_TRUE(hex_in.eof());
+
+    // with no base set, the prefix picks it, as for long
+    std::istringstream auto_in("0x1f 017 -0X" + hex_out.str().substr(1) +
+                               " 19 0");
+    auto_in >> std::setbase(0) >> a >> b >> c >> d >> e;
+    ASSERT_EQUAL(a, BigInt(31));
+    ASSERT_EQUAL(b, BigInt(15));
+    ASSERT_EQUAL(c, -big);
+    ASSERT_EQUAL(d, BigInt(19));
+    ASSERT_EQUAL(e, BigInt(0));
+    ASSERT_TRUE(auto_in.eof() && !auto_in.fail());
+}
+
+TEST(test_stats) {
+    BigIntStats::reset();
+    const BigInt a(digit_string(2000, 8));
+    const BigInt b(digit_string(1000, 9));
+    BigInt c = a * b;
+    c += a;
+    c -= b;
+    const std::string s = (c / b).to_string();
+    std::thread t([&] { c = a * a; }); // counted after the thread exits
+    t.join();
+    BigIntStats stats = BigIntStats::snapshot();
+    const BigIntStats::OperationStats& mul =
+        stats.operations[BigIntStats::MULTIPLY];
+    if (!BigIntStats::enabled) {
+        ASSERT_EQUAL(mul.calls, uint64_t(0));
+        ASSERT_EQUAL(stats.allocations, uint64_t(0));
+        ASSERT_EQUAL(stats.to_text(), "");
+        return;
+    }
+    ASSERT_EQUAL(mul.calls, uint64_t(2));
+    ASSERT_EQUAL(mul.sizes[7], uint64_t(2)); // a has 104 digits
+    ASSERT_TRUE(mul.cycles > 0);
+    ASSERT_EQUAL(stats.operations[BigIntStats::FROM_STRING].calls,
+                 uint64_t(2));
+    ASSERT_EQUAL(stats.operations[BigIntStats::ADD].calls, uint64_t(1));
+    ASSERT_EQUAL(stats.operations[BigIntStats::SUBTRACT].calls, uint64_t(1));
+    ASSERT_EQUAL(stats.operations[BigIntStats::DIVIDE].calls, uint64_t(1));
+    ASSERT_EQUAL(stats.operations[BigIntStats::TO_STRING].calls,
+                 uint64_t(1));
+    ASSERT_TRUE(stats.algorithms[BigIntStats::MUL_KARATSUBA] > 0);
+    ASSERT_TRUE(stats.algorithms[BigIntStats::MUL_BASECASE] > 0);
+    ASSERT_TRUE(stats.allocations > 0);
+    ASSERT_TRUE(stats.allocated_bytes >= 8 * stats.allocations);
+    ASSERT_TRUE(stats.to_json().find(
+        "\"multiply\": {\"calls\": 2, ") != std::string::npos);
+    ASSERT_TRUE(stats.to_text().find("multiply: 2 calls") == 0 ||
+                stats.to_text().find("\nmultiply: 2 calls") !=
+                    std::string::npos);
+
+    BigIntStats::reset();
+    stats = BigIntStats::snapshot();
+    ASSERT_EQUAL(stats.operations[BigIntStats::MULTIPLY].calls, uint64_t(0));
+    ASSERT_EQUAL(stats.allocations, uint64_t(0));
+
+    // the other entry points, once per element; out[0] aliases an operand
+    std::vector<BigInt> xs = {a, b, c};
+    std::vector<BigInt> out = {a, BigInt(), BigInt()};
+    BigInt::multiply_batch(xs.data(), xs.data(), out.data(), 3);
+    BigInt::add_batch(xs.data(), xs.data(), out.data(), 3);
+    BigInt p = BigInt::pow(a, 3);
+    std::istringstream in(" -" + digit_string(400, 3));
+    in >> p;
+    stats = BigIntStats::snapshot();
+    ASSERT_EQUAL(stats.operations[BigIntStats::MULTIPLY].calls, uint64_t(4));
+    ASSERT_EQUAL(stats.operations[BigIntStats::ADD].calls, uint64_t(3));
+    ASSERT_EQUAL(stats.operations[BigIntStats::FROM_STRING].calls,
+                 uint64_t(1));
+    // 400 decimal digits take 21 of radix 2^64
+    ASSERT_EQUAL(stats.operations[BigIntStats::FROM_STRING].sizes[5],
+                 uint64_t(1));
+}
+
 TEST_MAIN()
@@ -0,0 +1,249 @@
+#ifndef DIGIT_VECTOR_H
+#define DIGIT_VECTOR_H
+
+// A vector of 64-bit digits for BigInt, with room for INLINE_CAPACITY
+// digits inside the object itself. Most BigInts fit in one or two machine
+// words, so they (and the temporaries the arithmetic operators build)
+// never touch the heap; a DigitVector only allocates once it grows past
+// the inline buffer.
+//
+// The interface is the subset of std::vector that BigInt uses, with the
+// same meaning. Iterators are plain pointers.
+//
+// Heap buffers come from the std::pmr::memory_resource that was the
+// calling thread's current_resource() when the vector was constructed,
+// or from plain new[] if that was null (the default). As with the
+// std::pmr containers, a copy uses the current resource rather than the
+// source's, a move-constructed vector takes over the source's resource,
+// and move assignment between vectors with different resources copies
+// the digits.
+
+#include <algorithm> // std::copy, std::fill, std::max
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+
+// BIGINT_STATS changes the inline reallocate() below, so it must be
+// defined for all of a program or none of it. Every file that includes
+// this header keeps a reference to a symbol that BigInt.cpp defines only
+// under the same setting, so a mismatch fails to link rather than leaving
+// the linker to pick either version of reallocate().
+#ifdef BIGINT_STATS
+extern const char bigint_library_built_with_BIGINT_STATS;
+__attribute__((used)) static const char* const bigint_stats_build_check =
+    &bigint_library_built_with_BIGINT_STATS;
+
+// counts a heap buffer for BigIntStats (in BigInt.cpp)
+void bigint_stats_allocation(size_t bytes);
+#else
+extern const char bigint_library_built_without_BIGINT_STATS;
+__attribute__((used)) static const char* const bigint_stats_build_check =
+    &bigint_library_built_without_BIGINT_STATS;
+#endif
+
+class DigitVector {
+    public:
+        typedef uint64_t value_type;
+        typedef uint64_t* iterator;
+        typedef const uint64_t* const_iterator;
+
+        static const size_t INLINE_CAPACITY = 2;
+
+        DigitVector()
+            : ptr(inline_digits), len(0), cap(INLINE_CAPACITY),
+              resource(current) { }
+
+        explicit DigitVector(const size_t n, const uint64_t val = 0)
+            : DigitVector() {
+            assign(n, val);
+        }
+
+        DigitVector(const uint64_t* first, const uint64_t* last)
+            : DigitVector() {
+            assign(first, last);
+        }
+
+        DigitVector(std::initializer_list<uint64_t> init)
+            : DigitVector() {
+            assign(init.begin(), init.end());
+        }
+
+        DigitVector(const DigitVector& other)
+            : DigitVector() {
+            assign(other.begin(), other.end());
+        }
+
+        DigitVector(DigitVector&& other) noexcept
+            : ptr(inline_digits), len(0), cap(INLINE_CAPACITY),
+              resource(other.resource) {
+            steal(other);
+        }
+
+        DigitVector& operator=(const DigitVector& other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        DigitVector& operator=(DigitVector&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            // inline digits are copied whichever resource either side uses
+            if (!other.is_inline() && (resource == other.resource
+                    || (resource && other.resource
+                        && resource->is_equal(*other.resource)))) {
+                release();
+                steal(other);
+            }
+            else {
+                assign(other.begin(), other.end());
+                other.len = 0;
+            }
+            return *this;
+        }
+
+        ~DigitVector() {
+            release();
+        }
+
+        size_t size() const { return len; }
+        size_t capacity() const { return cap; }
+        bool empty() const { return len == 0; }
+        bool is_inline() const { return ptr == inline_digits; }
+
+        // the resource this vector's heap buffer is allocated from, or
+        // null for new[]
+        std::pmr::memory_resource* get_resource() const {
+            return resource;
+        }
+
+        // the calling thread's resource for new vectors, or null for new[]
+        static std::pmr::memory_resource*& current_resource() {
+            return current;
+        }
+
+        uint64_t* data() { return ptr; }
+        const uint64_t* data() const { return ptr; }
+        iterator begin() { return ptr; }
+        iterator end() { return ptr + len; }
+        const_iterator begin() const { return ptr; }
+        const_iterator end() const { return ptr + len; }
+
+        uint64_t& operator[](const size_t i) { return ptr[i]; }
+        const uint64_t& operator[](const size_t i) const { return ptr[i]; }
+        uint64_t& back() { return ptr[len - 1]; }
+        const uint64_t& back() const { return ptr[len - 1]; }
+
+        // grows to exactly n digits if the current buffer is too small
+        void reserve(const size_t n) {
+            if (n > cap) {
+                reallocate(n);
+            }
+        }
+
+        void resize(const size_t n, const uint64_t val = 0) {
+            reserve(n);
+            if (n > len) {
+                std::fill(ptr + len, ptr + n, val);
+            }
+            len = n;
+        }
+
+        void assign(const size_t n, const uint64_t val) {
+            len = 0;
+            resize(n, val);
+        }
+
+        // [first, last) must not point into this vector
+        void assign(const uint64_t* first, const uint64_t* last) {
+            const size_t n = size_t(last - first);
+            len = 0;
+            reserve(n);
+            std::copy(first, last, ptr);
+            len = n;
+        }
+
+        void push_back(const uint64_t val) {
+            if (len == cap) {
+                reallocate(std::max(2 * cap, len + 1));
+            }
+            ptr[len++] = val;
+        }
+
+        void pop_back() {
+            assert(len > 0);
+            --len;
+        }
+
+        void clear() {
+            len = 0;
+        }
+
+        void swap(DigitVector& other) {
+            DigitVector tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+    private:
+        uint64_t* ptr; // inline_digits, or a heap buffer of cap digits
+        size_t len;
+        size_t cap;
+        uint64_t inline_digits[INLINE_CAPACITY];
+        std::pmr::memory_resource* resource; // null for new[]
+
+        inline static thread_local std::pmr::memory_resource* current =
+            nullptr;
+
+        void reallocate(const size_t new_cap) {
+#ifdef BIGINT_STATS
+            bigint_stats_allocation(new_cap * sizeof(uint64_t));
+#endif
+            uint64_t* p = resource
+                ? static_cast<uint64_t*>(resource->allocate(
+                      new_cap * sizeof(uint64_t), alignof(uint64_t)))
+                : new uint64_t[new_cap];
+            std::copy(ptr, ptr + len, p);
+            release();
+            ptr = p;
+            cap = new_cap;
+        }
+
+        void release() {
+            if (!is_inline()) {
+                if (resource) {
+                    resource->deallocate(ptr, cap * sizeof(uint64_t),
+                                         alignof(uint64_t));
+                }
+                else {
+                    delete[] ptr;
+                }
+                ptr = inline_digits;
+                cap = INLINE_CAPACITY;
+            }
+        }
+
+        // take other's digits, leaving it empty; this must be inline and
+        // share other's resource
+        void steal(DigitVector& other) {
+            if (other.is_inline()) {
+                std::copy(other.begin(), other.end(), inline_digits);
+                len = other.len;
+            }
+            else {
+                resource = other.resource;
+                ptr = other.ptr;
+                len = other.len;
+                cap = other.cap;
+                other.ptr = other.inline_digits;
+                other.cap = INLINE_CAPACITY;
+            }
+            other.len = 0;
+        }
+};
+
+#endif // DIGIT_VECTOR_H
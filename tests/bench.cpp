@@ -0,0 +1,237 @@
+// Benchmarks every BigInt operation over operand sizes from 1 decimal digit
+// up to --max-digits (10^7 unless given), in steps of 10, and writes the
+// results to stdout as JSON:
+//
+//      {"threads": 1, "results": [
+//          {"op": "multiply", "digits": 1000, "batch": 1,
+//           "iterations": 4096, "ns_per_op": 1234.5, "mb_per_s": 678.9,
+//           "allocs_per_op": 1.0, "alloc_bytes_per_op": 848.0},
+//          ...]}
+//
+// "digits" is the decimal length of each operand (the divisor of "divide"
+// has half as many), and "batch" the number of operand pairs that batch
+// operations work on per call; ns_per_op is per call. "mb_per_s" is the
+// operands' binary size (8 bytes per radix 2^64 digit) processed per
+// second. Allocations are counted by replacing the global operator new,
+// so they include every heap buffer the operation touches, temporaries
+// and results alike.
+//
+// Build and run with `make bench`; options:
+//      --max-digits N      largest operand size
+//      --min-time S        seconds to repeat each operation for (0.2)
+//      --threads N         BigInt::set_threads(N) (1)
+//      --only OP           only the named operation
+
+#include "BigInt.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<size_t> alloc_count(0);
+static std::atomic<size_t> alloc_bytes(0);
+
+// The replacements are kept out of line, or GCC sees std::free called on
+// what it thinks came from operator new and warns.
+#define NOINLINE __attribute__((noinline))
+
+NOINLINE void* operator new(size_t size) {
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+NOINLINE void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+NOINLINE void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// a deterministic n-digit pseudo-random decimal string
+static std::string digit_string(const size_t n, unsigned seed) {
+    std::string s;
+    s.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        s.push_back(char('0' + (seed >> 16) % 10));
+    }
+    s[0] = '7';
+    return s;
+}
+
+// the number of operand pairs a batch operation works on at each size
+static size_t batch_size(const size_t digits) {
+    return std::max<size_t>(1, std::min<size_t>(1000, 1000000 / digits));
+}
+
+struct Options {
+    size_t max_digits = 10000000;
+    double min_time = 0.2;
+    unsigned threads = 1;
+    std::string only;
+};
+
+class Bench {
+    public:
+        explicit Bench(const Options& options_in)
+            : options(options_in) { }
+
+        // time f, which processes operand_bytes in batch operations per
+        // call, repeating it until min_time has passed, and report it as op
+        // at digits
+        template <class F>
+        void run(const char* op, const size_t digits,
+                 const size_t operand_bytes, F f, const size_t batch = 1) {
+            if (!options.only.empty() && options.only != op) {
+                return;
+            }
+            typedef std::chrono::steady_clock clock;
+            f(); // warm up
+            size_t iterations = 1;
+            double seconds = 0;
+            size_t allocs = 0;
+            size_t bytes = 0;
+            while (true) {
+                const size_t count0 = alloc_count.load();
+                const size_t bytes0 = alloc_bytes.load();
+                const clock::time_point start = clock::now();
+                for (size_t i = 0; i < iterations; ++i) {
+                    f();
+                }
+                seconds = std::chrono::duration<double>(clock::now() - start)
+                              .count();
+                allocs = alloc_count.load() - count0;
+                bytes = alloc_bytes.load() - bytes0;
+                if (seconds >= options.min_time) {
+                    break;
+                }
+                // aim a little past min_time next round
+                const double scale = seconds > 0
+                    ? 1.2 * options.min_time / seconds : 10;
+                iterations = std::max(iterations + 1,
+                    size_t(double(iterations) * std::min(scale, 10.0)));
+            }
+            const double n = double(iterations);
+            std::printf("%s\n    {\"op\": \"%s\", \"digits\": %zu, "
+                        "\"batch\": %zu, "
+                        "\"iterations\": %zu, \"ns_per_op\": %.1f, "
+                        "\"mb_per_s\": %.2f, \"allocs_per_op\": %.2f, "
+                        "\"alloc_bytes_per_op\": %.1f}",
+                        first ? "" : ",", op, digits, batch, iterations,
+                        seconds * 1e9 / n,
+                        double(operand_bytes) * n / seconds / 1e6,
+                        double(allocs) / n, double(bytes) / n);
+            std::fflush(stdout);
+            first = false;
+        }
+
+    private:
+        const Options options;
+        bool first = true;
+};
+
+// bytes of the radix 2^64 digits of x
+static size_t binary_size(const BigInt& x) {
+    return x.serialized_size() - 16;
+}
+
+static void bench_size(Bench& bench, const size_t n) {
+    const std::string sa = digit_string(n, 1);
+    const std::string sb = digit_string(n, 2);
+    const BigInt a(sa);
+    const BigInt b(sb);
+    const BigInt divisor(digit_string(std::max<size_t>(1, n / 2), 3));
+    const size_t ab_bytes = binary_size(a) + binary_size(b);
+    BigInt r;
+    bool flag = false;
+
+    bench.run("construct", n, binary_size(a), [&] { r = BigInt(sa); });
+    bench.run("to_string", n, binary_size(a), [&] {
+        flag ^= a.to_string().empty();
+    });
+    bench.run("add", n, ab_bytes, [&] { r = a + b; });
+    bench.run("subtract", n, ab_bytes, [&] { r = a - b; });
+    bench.run("multiply", n, ab_bytes, [&] { r = a * b; });
+    bench.run("divide", n, binary_size(a) + binary_size(divisor), [&] {
+        r = a / divisor;
+    });
+    bench.run("compare", n, ab_bytes, [&] { flag ^= a < b; });
+    bench.run("equal", n, ab_bytes, [&] { flag ^= a == b; });
+
+    const size_t count = batch_size(n);
+    const std::vector<BigInt> as(count, a);
+    const std::vector<BigInt> bs(count, b);
+    std::vector<BigInt> out(count);
+    std::vector<std::string> strings(count);
+    bench.run("multiply_batch", n, count * ab_bytes, [&] {
+        BigInt::multiply_batch(as.data(), bs.data(), out.data(), count);
+    }, count);
+    bench.run("add_batch", n, count * ab_bytes, [&] {
+        BigInt::add_batch(as.data(), bs.data(), out.data(), count);
+    }, count);
+    bench.run("to_string_batch", n, count * binary_size(a), [&] {
+        BigInt::to_string_batch(as.data(), strings.data(), count);
+    }, count);
+    if (flag && r.is_negative()) {
+        std::fprintf(stderr, "unreachable\n"); // keeps the results live
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--max-digits") {
+            options.max_digits = std::strtoull(value, nullptr, 10);
+        }
+        else if (arg == "--min-time") {
+            options.min_time = std::strtod(value, nullptr);
+        }
+        else if (arg == "--threads") {
+            options.threads = unsigned(std::strtoul(value, nullptr, 10));
+        }
+        else if (arg == "--only") {
+            options.only = value;
+        }
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    BigInt::set_threads(options.threads);
+
+    Bench bench(options);
+    std::printf("{\"threads\": %u, \"results\": [", BigInt::threads());
+    for (size_t n = 1; n <= options.max_digits; n *= 10) {
+        bench_size(bench, n);
+    }
+    std::printf("\n]}\n");
+}